@@ -17,8 +17,6 @@ WavetableVisualizer::WavetableVisualizer(int osc, GayPolyCommunistAudioProcessor
 {
     setSize(400, 150);
     setNewWaveColour(juce::Colours::white);
-
-    waveParser = std::make_unique<WavetableParser>(processor);
 }
 
 WavetableVisualizer::~WavetableVisualizer()
@@ -39,7 +37,10 @@ void WavetableVisualizer::paint (juce::Graphics& g)
     g.setColour({ 192, 172, 119 });
     g.drawRoundedRectangle(waveFrame.toFloat(), 5.f, 3.f);
 
-    if (waveVector.isFinishedLoading())
+    // the processor's copy of the bank, the voices' one can be swapped out by the audio thread at any time
+    auto bank = processor.getWaveBank(oscNum);
+
+    if (bank->getNumTables() > 0)
     {
         Path wavePath;
 
@@ -56,28 +57,28 @@ void WavetableVisualizer::paint (juce::Graphics& g)
 
         }
         auto waveVal = waveParam->getValue();
-        auto mappedVal = jmap(waveVal, 0.f, (float)waveVector.getArraySize() - 1);
+        auto mappedVal = jmap(waveVal, 0.f, (float)bank->getNumTables() - 1);
         // i chose to calc this here as opposed to just doing it in the vector because I couldn't smooth the waveIndices (not sure if this is smart)_
         // They are potentially changing at the sample level so I thought it best to pass the smoothed wavePos value only
         int lowerWaveIndex = (int)mappedVal;
         int upperWaveIndex = lowerWaveIndex + 1;
 
-        if (upperWaveIndex > waveVector.getArraySize())
+        if (upperWaveIndex > bank->getNumTables() - 1)
         {
             upperWaveIndex = 0;
         }
         
         float interp = mappedVal - (float)lowerWaveIndex;
 
-        auto waveLow = waveVector.getLowerWave(lowerWaveIndex)->getBuffer();
-        auto waveHigh = waveVector.getUpperWave(upperWaveIndex)->getBuffer();
+        auto& waveLow = bank->getTable(lowerWaveIndex).getBuffer();
+        auto& waveHigh = bank->getTable(upperWaveIndex).getBuffer();
 
         auto buffRead0 = waveLow.getReadPointer(0);
         auto buffRead1 = waveHigh.getReadPointer(0);
 
-        float waveIncrement = (float)w / waveVector.getTableSize();
+        float waveIncrement = (float)w / WavetableBank::tableSize;
 
-        for (int i = 0; i <= waveVector.getTableSize(); ++i)
+        for (int i = 0; i < WavetableBank::tableSize; ++i)
         {
             auto x = i * waveIncrement;
             auto value0 = buffRead0[i] * (1.f - interp);
@@ -95,7 +96,20 @@ void WavetableVisualizer::paint (juce::Graphics& g)
         PathStrokeType stroke(strokeThickness, juce::PathStrokeType::curved);
         g.strokePath(wavePath, stroke);
     }
-    
+
+    // anything still loading for this oscillator, the editor's timer repaints often enough to animate it
+    auto status = processor.getWaveLoadStatus(oscNum);
+
+    if (status.isLoading)
+    {
+        auto bar = waveFrame.reduced(10).removeFromBottom(16).toFloat();
+
+        g.setColour(Colours::black.withAlpha(0.4f));
+        g.fillRoundedRectangle(bar, 3.f);
+        g.setColour({ 217, 205, 151 });
+        g.fillRoundedRectangle(bar.withWidth(bar.getWidth() * status.progress), 3.f);
+        g.drawText("Loading " + status.name, bar.translated(0.f, -bar.getHeight()), Justification::centredLeft);
+    }
 
 }
 
@@ -116,12 +130,8 @@ bool WavetableVisualizer::isInterestedInFileDrag(const StringArray& files)
 
 void WavetableVisualizer::filesDropped(const StringArray& files, int x, int y)
 {
-    processor.shouldProcess(false);
-
-    auto file = File(files[0]);
-    waveParser->loadFileToOsc(file, oscNum);
+    // cut up and built on the wave loader's threads, then faded in, so neither the editor nor playback waits on it
+    processor.loadWaveFile(File(files[0]), oscNum);
     
    // processor.loadWaveTables(files, oscNum);
-    
-    processor.shouldProcess(true);
 }
@@ -12,7 +12,6 @@
 
 #include <JuceHeader.h>
 #include "../WaveTable/WaveTableVector.h"
-#include "../WaveTable/WavetableParser.h"
 #include "../Processor/PluginProcessor.h"
 
 //==============================================================================
@@ -63,8 +62,6 @@ private:
     float bgHue = 0.f;
     float bgVal;
 
-    std::unique_ptr<WavetableParser> waveParser;
-    
     GayPolyCommunistAudioProcessor& processor;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableVisualizer)
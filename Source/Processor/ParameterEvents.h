@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    ParameterEvents.h
+    Created: 17 Oct 2026 10:12:40pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+struct ParameterEvent
+{
+    int parameterIndex = 0;
+    float value = 0.f;      // plain value, same as getRawParameterValue() gives
+    int sampleOffset = 0;   // where in the next block it lands
+};
+
+/*
+    Parameter changes on their way to processBlock.
+    Anything can push (the host sets automation from its audio thread, the editor from the message thread), only
+    processBlock pops. Pushing never waits: if another thread is mid push or the queue is full it gives up and the
+    caller falls back to a full update(), which reads every parameter's latest value anyway.
+*/
+class ParameterEventQueue
+{
+public:
+    static constexpr int capacity = 1024;
+
+    bool push(const ParameterEvent& event)
+    {
+        const SpinLock::ScopedTryLockType lock(pushLock);
+        if (! lock.isLocked())
+            return false;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        events[size1 > 0 ? start1 : start2] = event;
+        fifo.finishedWrite(1);
+        return true;
+    }
+
+    // audio thread. Everything queued so far, offsets kept inside the block and sorted (same offset keeps its order)
+    int pop(ParameterEvent* dest, int maxEvents, int numSamples)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(jmin(maxEvents, fifo.getNumReady()), start1, size1, start2, size2);
+
+        int numEvents = 0;
+        for (int i = 0; i < size1; ++i)
+            dest[numEvents++] = events[start1 + i];
+        for (int i = 0; i < size2; ++i)
+            dest[numEvents++] = events[start2 + i];
+
+        fifo.finishedRead(size1 + size2);
+
+        // nearly always in order already, so insertion sort
+        for (int i = 0; i < numEvents; ++i)
+        {
+            auto event = dest[i];
+            event.sampleOffset = jlimit(0, jmax(0, numSamples - 1), event.sampleOffset);
+
+            auto j = i;
+            for (; j > 0 && dest[j - 1].sampleOffset > event.sampleOffset; --j)
+                dest[j] = dest[j - 1];
+
+            dest[j] = event;
+        }
+
+        return numEvents;
+    }
+
+private:
+    AbstractFifo fifo { capacity };
+    std::array<ParameterEvent, capacity> events;
+    SpinLock pushLock;
+};
@@ -23,15 +23,24 @@ GayPolyCommunistAudioProcessor::GayPolyCommunistAudioProcessor()
 #endif
 {
     apvts.state.addListener(this);
+    initParameterEvents();
 
 
     waveDatabase.loadFiles();
+    buildVoices();
+
+    // the default vector, read from disk once for both oscillators of every voice. They play a sine until it's there
+    waveLoader.loadFiles(StringArray(WaveDatabase::getWaveTableRoot().getChildFile("Vector 1").getFullPathName()), 0);
+
     update();
 }
 
 GayPolyCommunistAudioProcessor::~GayPolyCommunistAudioProcessor()
 {
     apvts.state.removeListener(this);
+
+    for (auto* param : getParameters())
+        param->removeListener(this);
 }
 
 //==============================================================================
@@ -101,6 +110,7 @@ void GayPolyCommunistAudioProcessor::prepareToPlay (double sampleRate, int sampl
 {
     dsp::ProcessSpec spec{ sampleRate, (juce::uint32)samplesPerBlock, 2 };
     synth.prepare(spec);
+    updateOversampling();
     update();
 }
 
@@ -138,6 +148,7 @@ bool GayPolyCommunistAudioProcessor::isBusesLayoutSupported (const BusesLayout&
 
 void GayPolyCommunistAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    GPC_RT_AUDIO_SCOPE
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -164,9 +175,34 @@ void GayPolyCommunistAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
     }
     
 
-    if (processing.get() && checkVoices())
+    auto numSamples = buffer.getNumSamples();
+    auto numEvents = parameterEvents.pop(blockEvents.data(), (int)blockEvents.size(), numSamples);
+
+    for (int e = 0; e < numEvents; ++e)
+        ++pendingEvents[(size_t)blockEvents[e].parameterIndex];
+
+    auto shouldRender = processing.get() && (! voiceCheckEnabled.get() || checkVoices());
+
+    // a wavetable bank published since the last block gets picked up here, before anything renders
+    synth.beginBlock(numSamples);
+
+    // the block gets split wherever a parameter changes, each piece renders with everything that landed at its start
+    int position = 0, nextEvent = 0;
+    while (position < numSamples || nextEvent < numEvents) // an empty block still takes its events
     {
-        synth.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
+        auto groups = 0;
+        while (nextEvent < numEvents && blockEvents[nextEvent].sampleOffset <= position)
+            groups |= applyParameterEvent(blockEvents[nextEvent++]);
+
+        if (groups != 0)
+            updateGroups(groups);
+
+        auto end = nextEvent < numEvents ? blockEvents[nextEvent].sampleOffset : numSamples;
+
+        if (shouldRender && end > position)
+            synth.renderNextBlock(buffer, midiMessages, position, end - position);
+
+        position = end;
     }
     
     for (int chan = 0; chan < buffer.getNumChannels(); chan++)
@@ -202,12 +238,100 @@ void GayPolyCommunistAudioProcessor::setStateInformation (const void* data, int
     std::unique_ptr<juce::XmlElement> xml = getXmlFromBinary(data, sizeInBytes);
     juce::ValueTree copyState = juce::ValueTree::fromXml(*xml.get());
     apvts.replaceState(copyState);
+    buildVoices();
+    mustUpdateProcessing = true; // don't wait on the value tree callback, the next block should already sound like the preset
 }
 
 void GayPolyCommunistAudioProcessor::update()
 {
     synth.update(apvts);
     mustUpdateProcessing = false;
+
+    // update() gave the voices every parameter's latest value, anything with a change still to come in this block
+    // goes back to what it had until then
+    for (size_t i = 0; i < paramTargets.size(); ++i)
+    {
+        if (! paramTargets[i].isValid())
+            continue;
+
+        if (pendingEvents[i] > 0)
+            synth.setParameter(paramTargets[i], voiceValues[i]);
+        else
+            voiceValues[i] = rawValues[i]->load();
+    }
+}
+
+void GayPolyCommunistAudioProcessor::initParameterEvents()
+{
+    for (auto* param : getParameters())
+    {
+        auto* ranged = dynamic_cast<RangedAudioParameter*>(param);
+        auto id = ranged != nullptr ? ranged->paramID : String();
+
+        paramTargets.push_back(GayVoice::getParamTarget(id));
+        paramGroups.push_back(GayVoice::getParamGroup(id));
+        rawValues.push_back(apvts.getRawParameterValue(id));
+        voiceValues.push_back(ranged != nullptr ? ranged->convertFrom0to1(ranged->getValue()) : 0.f);
+        pendingEvents.push_back(0);
+
+        param->addListener(this);
+    }
+}
+
+int GayPolyCommunistAudioProcessor::applyParameterEvent(const ParameterEvent& event)
+{
+    auto index = (size_t)event.parameterIndex;
+    --pendingEvents[index];
+
+    if (! paramTargets[index].isValid())
+    {
+        // these take their latest value, so several in one block all land at the first one
+        auto group = paramGroups[index];
+        return group != GayVoice::ParamGroup::none ? 1 << (int)group : 0;
+    }
+
+    voiceValues[index] = event.value;
+    synth.setParameter(paramTargets[index], event.value);
+    return 0;
+}
+
+// none of the groups touch a smoothed value, so unlike update() nothing has to be put back afterwards
+void GayPolyCommunistAudioProcessor::updateGroups(int groups)
+{
+    for (int group = 0; group < GayVoice::numParamGroups; ++group)
+        if ((groups & (1 << group)) != 0)
+            synth.updateGroup((GayVoice::ParamGroup)group, apvts);
+}
+
+void GayPolyCommunistAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    if (parameterIndex == queueingParameter.get())
+        return;
+
+    auto* param = dynamic_cast<RangedAudioParameter*>(getParameters()[parameterIndex]);
+    if (param == nullptr)
+        return;
+
+    // there's no telling where in the block the host meant it, so it goes at the start
+    if (! parameterEvents.push({ parameterIndex, param->convertFrom0to1(newValue), 0 }))
+        mustUpdateProcessing = true;
+}
+
+void GayPolyCommunistAudioProcessor::queueParameterChange(const String& parameterID, float value, int sampleOffset)
+{
+    auto* param = apvts.getParameter(parameterID);
+    if (param == nullptr)
+        return;
+
+    auto index = param->getParameterIndex();
+    auto normalised = param->convertTo0to1(value);
+
+    if (! parameterEvents.push({ index, param->convertFrom0to1(normalised), sampleOffset }))
+        mustUpdateProcessing = true;
+
+    queueingParameter = index;
+    param->setValueNotifyingHost(normalised);
+    queueingParameter = -1;
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout GayPolyCommunistAudioProcessor::createParameters()
@@ -259,6 +383,13 @@ juce::AudioProcessorValueTreeState::ParameterLayout GayPolyCommunistAudioProcess
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Wave 1 Env Source", "Wave 1 Env Source", 0, 3, 0));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Wave 1 Env Scale", "Wave 1 Env Scale", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
 
+    // unison stack, 1 voice is the plain oscillator
+    params.push_back(std::make_unique<juce::AudioParameterInt>("Unison Voices 1", "Unison Voices 1", 1, UnisonStack::maxVoices, 1));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("Unison Detune 1", "Unison Detune 1", NormalisableRange<float>(0.0f, 100.0f, 0.01f), 20.f)); // cents
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("Unison Spread 1", "Unison Spread 1", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("Unison Blend 1", "Unison Blend 1", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 1.f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("Unison Phase 1", "Unison Phase 1", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 1.f));
+
 
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Gain 2", "Gain 2", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Gain 2 LFO Source", "Gain 2 LFO Source", 0.f, 3.f, 0.f));// 0 = no modulator1
@@ -278,6 +409,13 @@ juce::AudioProcessorValueTreeState::ParameterLayout GayPolyCommunistAudioProcess
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Wave 2 Env Source", "Wave 2 Env Source", 0, 3, 0));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Wave 2 Env Scale", "Wave 2 Env Scale", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
 
+    // unison stack, 1 voice is the plain oscillator
+    params.push_back(std::make_unique<juce::AudioParameterInt>("Unison Voices 2", "Unison Voices 2", 1, UnisonStack::maxVoices, 1));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("Unison Detune 2", "Unison Detune 2", NormalisableRange<float>(0.0f, 100.0f, 0.01f), 20.f)); // cents
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("Unison Spread 2", "Unison Spread 2", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("Unison Blend 2", "Unison Blend 2", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 1.f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("Unison Phase 2", "Unison Phase 2", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 1.f));
+
 
     // Filter params (held in voice class rather than individual oscillators
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Filter Freq", "Filter Freq", NormalisableRange<float>(100.0f, 15000.0f, 0.001f, 0.5f), 500.f));
@@ -292,6 +430,10 @@ juce::AudioProcessorValueTreeState::ParameterLayout GayPolyCommunistAudioProcess
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Res Env Source", "Res Env Source", 0, 3, 0));// 0 = no modulator
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Res Env Scale", "Res Env Scale", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
 
+    // oversampling around the filter / drive, the linear phase filters add latency
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling", StringArray{ "Off", "2x", "4x", "8x" }, 0));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("Oversampling Filter", "Oversampling Filter", StringArray{ "Polyphase IIR", "Linear Phase FIR" }, 0));
+
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Filter Drive", "Filter Drive", NormalisableRange<float>(1.0f, 10.0f, 0.001f), 1.f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Drive LFO Source", "Drive LFO Source", 0, 3, 0));// 0 = no modulator
     params.push_back(std::make_unique<juce::AudioParameterFloat>("Drive LFO Scale", "Drive LFO Scale", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
@@ -318,6 +460,12 @@ juce::AudioProcessorValueTreeState::ParameterLayout GayPolyCommunistAudioProcess
     params.push_back(std::make_unique<juce::AudioParameterFloat>("LFO Depth Env Source 3", "LFO Depth Env Source 3", 0, 3, 0));// 0 = no modulator
     params.push_back(std::make_unique<juce::AudioParameterFloat>("LFO Depth Env Scale 3", "LFO Depth Env Scale 3", NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
 
+    params.push_back(std::make_unique<juce::AudioParameterInt>("Polyphony", "Polyphony", 1, GaySynth::maxPolyphony, GaySynth::defaultPolyphony));
+
+    // how often the voices work out their modulation, "Audio" is every sample (see ControlRate.h)
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("Control Rate", "Control Rate", ControlTicks::getChoices(), 0));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("Control Interp", "Control Interp", StringArray{ "Linear", "Cubic" }, 0));
+
     return { params.begin(), params.end() };
 }
 
@@ -341,6 +489,11 @@ void GayPolyCommunistAudioProcessor::shouldProcess(bool isProcessing)
     processing = isProcessing;
 }
 
+void GayPolyCommunistAudioProcessor::setVoiceCheckEnabled(bool shouldCheck)
+{
+    voiceCheckEnabled = shouldCheck;
+}
+
 bool GayPolyCommunistAudioProcessor::checkVoices()
 {
     bool allLoaded = false;
@@ -443,27 +596,73 @@ WaveDatabase& GayPolyCommunistAudioProcessor::getWaveDatabase()
 
 void GayPolyCommunistAudioProcessor::loadWaveTables(const StringArray& files, int oscNum)
 {
-    for (auto file : files)
-    {
-        for (int voiceNum = 0; voiceNum < synth.getNumVoices(); voiceNum++)
-        {
-            if (auto voice = dynamic_cast<GayVoice*>(synth.getVoice(voiceNum)))
-            {
-                voice->loadTables(file, oscNum);
-            }
-        }
-    }
+    waveLoader.loadFiles(files, oscNum);
 }
 
 void GayPolyCommunistAudioProcessor::loadTableFromBuffer(AudioBuffer<float>& waveBuffer, int oscNum)
 {
-    for (int voiceNum = 0; voiceNum < synth.getNumVoices(); voiceNum++)
-    {
-        if (auto voice = dynamic_cast<GayVoice*>(synth.getVoice(voiceNum)))
-        {
-            voice->loadTableFromBuffer(waveBuffer, oscNum);
-        }
-    }
+    waveLoader.loadCycles({ waveBuffer }, oscNum);
+}
+
+void GayPolyCommunistAudioProcessor::loadWaveFile(const File& recording, int oscNum)
+{
+    waveLoader.loadSlices(recording, oscNum);
+}
+
+void GayPolyCommunistAudioProcessor::clearWaveTables(int oscNum)
+{
+    waveLoader.clear(oscNum);
+}
+
+void GayPolyCommunistAudioProcessor::waitForWaveTables()
+{
+    waveLoader.waitUntilIdle();
+}
+
+WavetableBank::Ptr GayPolyCommunistAudioProcessor::getWaveBank(int oscNum) const
+{
+    return waveLoader.getBank(oscNum);
+}
+
+WaveTableLoader::Status GayPolyCommunistAudioProcessor::getWaveLoadStatus(int oscNum) const
+{
+    return waveLoader.getStatus(oscNum);
+}
+
+void GayPolyCommunistAudioProcessor::setReferenceQuality(bool shouldUseReference)
+{
+    synth.setReferenceQuality(shouldUseReference);
 }
 
+void GayPolyCommunistAudioProcessor::setInterpolation(bool forReferenceQuality, TableInterpolation::Kernel kernel)
+{
+    synth.setInterpolation(forReferenceQuality, kernel);
+}
 
+void GayPolyCommunistAudioProcessor::setPolyphony(int numVoices)
+{
+    if (auto* param = apvts.getParameter("Polyphony"))
+        param->setValueNotifyingHost(param->convertTo0to1((float)numVoices));
+
+    buildVoices();
+    mustUpdateProcessing = true;
+}
+
+// building voices allocates and loads tables, so it happens here on the message thread and processBlock only ever moves the limit
+void GayPolyCommunistAudioProcessor::buildVoices()
+{
+    synth.buildVoices((int)apvts.getRawParameterValue("Polyphony")->load());
+    updateOversampling();
+}
+
+// switching filter designs rebuilds the oversamplers, so that's message thread too. The latency follows the factor
+void GayPolyCommunistAudioProcessor::updateOversampling()
+{
+    synth.setOversamplingFilter(apvts.getRawParameterValue("Oversampling Filter")->load() > 0.5f);
+
+    auto isFiltering = (int)apvts.getRawParameterValue("Filter Mode")->load() != 2; // 2 = filter off, nothing gets oversampled
+    auto latency = isFiltering ? synth.getOversamplingLatency((int)apvts.getRawParameterValue("Oversampling")->load()) : 0;
+
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+}
@@ -11,12 +11,16 @@
 #include <JuceHeader.h>
 #include "../Synth/GaySynth.h"
 #include "WaveDatabase.h"
+#include "RealtimeSanitizer.h"
+#include "ParameterEvents.h"
+#include "../WaveTable/WaveTableLoader.h"
 
 //==============================================================================
 /**
 */
 class GayPolyCommunistAudioProcessor  : public juce::AudioProcessor,
-    public juce::ValueTree::Listener
+    public juce::ValueTree::Listener,
+    public juce::AudioProcessorParameter::Listener
 {
 public:
     //==============================================================================
@@ -58,6 +62,13 @@ public:
     
     void update();
 
+    /*
+        Sample accurate automation, for callers that know where in the next block a change goes (the offline tools,
+        hosts only ever give us one value per block). Sets the parameter straight away, the voices switch over to it
+        sampleOffset samples into the next processBlock. Not from the audio thread
+    */
+    void queueParameterChange(const juce::String& parameterID, float value, int sampleOffset);
+
     juce::AudioProcessorValueTreeState& getValueTree() { return apvts; }
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
@@ -66,6 +77,7 @@ public:
 
     void shouldProcess(bool isProcessing);
     bool checkVoices();
+    void setVoiceCheckEnabled(bool shouldCheck); // offline renders skip the per block loading check
 
     float getRMS();
 
@@ -85,8 +97,27 @@ public:
 
     WaveDatabase& getWaveDatabase();
 
+    /*
+        Each queues a new bank for the oscillator on the wave loader (WaveTableLoader) and returns straight away,
+        the voices fade over to it once it's built. Banks arrive in the order they're asked for
+    */
     void loadWaveTables(const StringArray& filePath, int oscNum);
     void loadTableFromBuffer(AudioBuffer<float>& wave, int oscNum);
+    void loadWaveFile(const File& recording, int oscNum); // cut into cycles, see WavetableParser
+    void clearWaveTables(int oscNum);
+
+    // waits until every load asked for so far has been published (the offline tools, so renders start on the right tables)
+    void waitForWaveTables();
+
+    // the last bank built for an oscillator, what its voices are playing or about to be. Not the audio thread
+    WavetableBank::Ptr getWaveBank(int oscNum) const;
+
+    // how far along an oscillator's loads are, the visualizer polls this
+    WaveTableLoader::Status getWaveLoadStatus(int oscNum) const;
+
+    void setReferenceQuality(bool shouldUseReference);
+    void setInterpolation(bool forReferenceQuality, TableInterpolation::Kernel kernel); // see GaySynth::setInterpolation
+    void setPolyphony(int numVoices); // message thread, builds any voices that don't exist yet
 
     float getLFODepth(int lfoNum);
 private:
@@ -100,6 +131,7 @@ private:
     juce::AudioProcessorValueTreeState apvts;
     juce::Atomic<bool> mustUpdateProcessing{ false };
     Atomic<bool> processing{ true };
+    Atomic<bool> voiceCheckEnabled{ true };
     Atomic<bool> noteOn{ false };
     Atomic<bool> noteOff{ false };
 
@@ -107,9 +139,38 @@ private:
 
     WaveDatabase waveDatabase;
 
+    // builds the banks in the background and publishes them to the synth, after synth so it's stopped first
+    WaveTableLoader waveLoader { [this](int oscNum, WavetableBank::Ptr bank) { synth.publishBank(oscNum, bank); } };
+
+    void buildVoices();
+    void updateOversampling();
+
+    // parameter changes in order of where they land, processBlock splits the block at each one
+    ParameterEventQueue parameterEvents;
+    std::array<ParameterEvent, ParameterEventQueue::capacity> blockEvents;
+
+    // all by parameter index
+    std::vector<GayVoice::ParamTarget> paramTargets;    // invalid ones go by their group instead
+    std::vector<GayVoice::ParamGroup> paramGroups;
+    std::vector<std::atomic<float>*> rawValues;
+    std::vector<float> voiceValues;                     // what the voices have right now, for the ones with a target
+    std::vector<int> pendingEvents;                     // how many are still to come in this block
+
+    juce::Atomic<int> queueingParameter{ -1 }; // queueParameterChange queues its own event, the listener skips this one
+
+    void initParameterEvents();
+    int applyParameterEvent(const ParameterEvent& event); // the bit of the ParamGroup it needs updated, 0 if none
+    void updateGroups(int groups);
+
+    // whoever changed it, host / editor / preset. Can be any thread
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {}
+
+    // the apvts flushes parameter changes into the tree from its timer, so this is on the message thread.
+    // The voices already got the change through parameterValueChanged, this only builds any voices polyphony needs
     void valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged, const juce::Identifier& property) override
     {
-        mustUpdateProcessing = true;
+        buildVoices();
     }
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GayPolyCommunistAudioProcessor)
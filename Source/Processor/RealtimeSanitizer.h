@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    RealtimeSanitizer.h
+    Created: 17 Oct 2026 3:41:09pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cstdio>
+
+/*
+    Debug mode that catches the audio thread doing things it shouldn't: allocating, freeing, locking a mutex or
+    touching files while it's inside processBlock.
+
+    processBlock opens a GPC_RT_AUDIO_SCOPE, which only marks the thread. The actual catching is done by the
+    malloc / pthread / file call interposers in Tools/Common/RealtimeSanitizer.cpp, which only get linked into the
+    headless tools when cmake is run with -DGPC_RT_SANITIZER=ON (never into the plugin, it's a shared library in
+    somebody else's process). Without the option the macros compile to nothing.
+*/
+namespace RealtimeSanitizer
+{
+    enum Kind
+    {
+        allocation,
+        deallocation,
+        mutexLock,
+        fileIO,
+        numKinds
+    };
+
+    // how deep the current thread is in audio callbacks, anything above 0 is checked
+    inline int& audioThreadDepth() noexcept
+    {
+        static thread_local int depth = 0;
+        return depth;
+    }
+
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() noexcept { ++audioThreadDepth(); }
+        ~ScopedAudioThread() noexcept { --audioThreadDepth(); }
+    };
+
+    // switches checking off on this thread for a while, the sanitizer uses it for its own bookkeeping
+    struct ScopedAllow
+    {
+        ScopedAllow() noexcept : saved(audioThreadDepth()) { audioThreadDepth() = 0; }
+        ~ScopedAllow() noexcept { audioThreadDepth() = saved; }
+
+        int saved;
+    };
+
+    // these live next to the interposers, only call them from a GPC_RT_SANITIZER build
+    int getNumViolations() noexcept;
+    void printViolations(FILE* out);
+    void clearViolations() noexcept;
+}
+
+#if GPC_RT_SANITIZER
+ #define GPC_RT_AUDIO_SCOPE RealtimeSanitizer::ScopedAudioThread gpcRtAudioScope;
+#else
+ #define GPC_RT_AUDIO_SCOPE
+#endif
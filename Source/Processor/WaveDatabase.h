@@ -49,9 +49,16 @@ public:
     WaveDatabase(){}
     ~WaveDatabase(){}
 
+    // C:/ProgramData/Recluse-Audio/GPC/WaveTables on windows, the equivalent shared data folder everywhere else
+    static juce::File getWaveTableRoot()
+    {
+        return juce::File::getSpecialLocation(juce::File::commonApplicationDataDirectory)
+            .getChildFile("Recluse-Audio/GPC/WaveTables");
+    }
+
     void loadFiles()
     {
-        auto folders = juce::File("C:/ProgramData/Recluse-Audio/GPC/WaveTables/").findChildFiles(1, true);
+        auto folders = getWaveTableRoot().findChildFiles(1, true);
 
         for (int i = 0; i < folders.size(); i++)
         {
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    ControlRate.h
+    Created: 17 Oct 2026 7:02:36pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/*
+    Control rate modulation.
+    At audio rate (interval 1) every lfo, envelope and param gets worked out once per sample. At control rate the
+    voice only works the modulators out once every `interval` samples (a tick), and what the oscillators read gets
+    spread back over the samples in between:
+        gain and the amp envelope  - linear
+        pitch and wave position    - linear or cubic, whatever the patch says
+    The filter and lfo rate / depth params are only looked at once per block / tick anyway, so they stay at tick rate.
+
+    Ticks start over at the start of each chunk the voice renders, so the last one in a chunk can be short.
+*/
+struct ControlTicks
+{
+    enum Interpolation
+    {
+        linear,
+        cubic
+    };
+
+    int interval = 1;       // samples per tick, 1 = audio rate
+    int numTicks = 0;       // ticks in the current chunk
+    int numSamples = 0;     // samples those ticks cover
+    Interpolation interpolation = linear;
+
+    bool isAudioRate() const
+    {
+        return interval <= 1;
+    }
+
+    int getTickLength(int tick) const
+    {
+        return jmin(interval, numSamples - tick * interval);
+    }
+
+    // "Control Rate" parameter choices
+    static StringArray getChoices()
+    {
+        return { "Audio", "8", "16", "32", "64" };
+    }
+
+    static int intervalForChoice(int choice)
+    {
+        const int intervals[] = { 1, 8, 16, 32, 64 };
+        return intervals[jlimit(0, 4, choice)];
+    }
+};
+
+/*
+    Spreads one value per tick back over the samples. Each tick's value lands on the last sample of that tick and the
+    samples before it ramp from the previous tick's value, so the modulation runs up to a tick late.
+    Cubic is a hermite curve with backward difference tangents: it only needs ticks that have already happened and
+    it stays smooth across tick boundaries (linear has a corner at every tick)
+*/
+class ControlInterpolator
+{
+public:
+    void reset()
+    {
+        primed = false;
+    }
+
+    void process(const float* ticks, const ControlTicks& info, float* dest, ControlTicks::Interpolation interpolation)
+    {
+        int pos = 0;
+
+        for (int t = 0; t < info.numTicks; ++t)
+        {
+            auto length = info.getTickLength(t);
+            auto target = ticks[t];
+
+            // first tick after a reset has nothing to ramp from
+            if (! primed)
+            {
+                last = target;
+                lastSlope = 0.f;
+                primed = true;
+            }
+
+            auto slope = target - last;
+            auto scale = 1.f / (float)length;
+
+            if (interpolation == ControlTicks::cubic)
+            {
+                for (int i = 1; i <= length; ++i)
+                {
+                    auto x = (float)i * scale;
+                    auto x2 = x * x;
+                    auto x3 = x2 * x;
+
+                    dest[pos++] = (2.f * x3 - 3.f * x2 + 1.f) * last
+                                + (x3 - 2.f * x2 + x) * lastSlope
+                                + (3.f * x2 - 2.f * x3) * target
+                                + (x3 - x2) * slope;
+                }
+            }
+            else
+            {
+                auto step = slope * scale;
+
+                for (int i = 1; i <= length; ++i)
+                    dest[pos++] = last + step * (float)i;
+            }
+
+            last = target;
+            lastSlope = slope;
+        }
+    }
+
+private:
+    float last = 0.f, lastSlope = 0.f;
+    bool primed = false;
+};
@@ -130,6 +130,78 @@ public:
         }
     }
 
+    /** Not from juce: moves the envelope on numSamples at once (control rate) and returns where it ends up.
+        The stages are straight lines, so this lands where numSamples calls to getNextSample() would, give or take rounding.
+    */
+    float advance(int numSamples) noexcept
+    {
+        while (numSamples > 0 && state != State::idle)
+        {
+            if (state == State::attack)
+            {
+                auto steps = stepsToCover(1.0f - envelopeVal, attackRate, numSamples);
+                envelopeVal += attackRate * (float)steps;
+                numSamples -= steps;
+
+                if (envelopeVal >= 1.0f)
+                {
+                    envelopeVal = 1.0f;
+                    goToNextState();
+                }
+            }
+            else if (state == State::decay)
+            {
+                auto steps = stepsToCover(envelopeVal - parameters.sustain, decayRate, numSamples);
+                envelopeVal -= decayRate * (float)steps;
+                numSamples -= steps;
+
+                if (envelopeVal <= parameters.sustain)
+                {
+                    envelopeVal = parameters.sustain;
+                    goToNextState();
+                }
+            }
+            else if (state == State::sustain)
+            {
+                envelopeVal = parameters.sustain;
+                break;
+            }
+            else if (state == State::release)
+            {
+                auto steps = stepsToCover(envelopeVal, releaseRate, numSamples);
+                envelopeVal -= releaseRate * (float)steps;
+                numSamples -= steps;
+
+                if (envelopeVal <= 0.0f)
+                    goToNextState();
+            }
+        }
+
+        return envelopeVal;
+    }
+
+    /** Not from juce: releases over a fixed (short) time whatever the release parameter says.
+        Used when a voice gets cut off, so it fades instead of clicking. Never makes a release that's already
+        going any slower.
+    */
+    void fastRelease(float seconds) noexcept
+    {
+        if (state == State::idle)
+            return;
+
+        auto fastRate = (float)(envelopeVal / (seconds * sampleRate));
+
+        if (fastRate <= 0.0f)
+        {
+            reset();
+        }
+        else if (state != State::release || fastRate > releaseRate)
+        {
+            releaseRate = fastRate;
+            state = State::release;
+        }
+    }
+
     //==============================================================================
     /** Returns the next sample value for an ADSR object.
 
@@ -214,6 +286,17 @@ public:
     {
         return envelopeVal;
     }
+
+    // the voice renders a block of envelope values ahead of time (GayVoice::renderControls), GayParam reads that block from here
+    void setBlockBuffer(float* buffer)
+    {
+        blockBuffer = buffer;
+    }
+
+    const float* getBlockBuffer() const
+    {
+        return blockBuffer;
+    }
 private:
     //==============================================================================
     void recalculateRates() noexcept
@@ -235,6 +318,15 @@ private:
         }
     }
 
+    // steps of rate it takes to cover distance, never more than maxSteps
+    static int stepsToCover(float distance, float rate, int maxSteps) noexcept
+    {
+        if (rate <= 0.0f)
+            return maxSteps;
+
+        return jlimit(1, maxSteps, (int)std::ceil(distance / rate));
+    }
+
     void goToNextState() noexcept
     {
         if (state == State::attack)
@@ -253,5 +345,6 @@ private:
 
     double sampleRate = 44100.0;
     float envelopeVal = 0.0f, attackRate = 0.0f, decayRate = 0.0f, releaseRate = 0.0f;
+    float* blockBuffer = nullptr;
 };
 
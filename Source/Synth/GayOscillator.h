@@ -13,6 +13,7 @@
 #include "../WaveTable/WaveTableVector.h"
 #include "GayADSR.h"
 #include "GayParam.h"
+#include "UnisonStack.h"
 
 
 //==============================================================================
@@ -32,8 +33,10 @@ public:
 
     ~GayOscillator(){}
 
-    void prepare(double sampleRate)
+    void prepare(double sampleRate, int maxBlockSize)
     {
+        controlBlock.setSize(numControls, jmax(1, maxBlockSize));
+
         waveVector.prepare(sampleRate);
         waveVector.setWave(0.5f);
 
@@ -41,11 +44,13 @@ public:
         pitch->prepare(sampleRate);
         wave->prepare(sampleRate);
 
+        unison.prepare(sampleRate);
     }
 
     void noteOn(float vel, float freq)
     {
         pitch->setValue(freq);
+        unison.noteOn();
     }
 
     void noteOff(){}
@@ -53,14 +58,6 @@ public:
     //==============================================================================
     void setFrequency(float newValue, bool force = false)
     {
-<<<<<<< HEAD
-        waveVector.setFrequency(newValue);
-    }
-
-    void setLevel(Type newValue)
-    {
-    }
-=======
         pitch->setValue(newValue);
         //waveVector.setFrequency(newValue);
     }
@@ -68,34 +65,133 @@ public:
     void setLevel(float newValue){}
 
     void reset() noexcept{}
->>>>>>> ed4bc7c8d6e98ab459f40b30c1c89b3989142bee
 
-    // iterates and returns
-    float getNextSample()
+    /*
+        iterates and hands back a sample, reading with Kernel (whoever loops over this has already dispatched on
+        getInterpolation()). A unison stack renders a sample of the whole stack, right is only different from left when isStereo()
+    */
+    template <typename Kernel = TableInterpolation::Linear>
+    void getNextSample(float& left, float& right, UnisonStack::Scratch& scratch)
     {
-<<<<<<< HEAD
-=======
-        waveVector.setWave(wave->getNextValue());
-        waveVector.setFrequency(pitch->getNextValue());
-        return waveVector.getNextSample() * gain->getNextValue();
->>>>>>> ed4bc7c8d6e98ab459f40b30c1c89b3989142bee
+        auto w = wave->getNextValue();
+        auto p = pitch->getNextValue();
+
+        if (isUnison())
+        {
+            unison.render<Kernel>(waveVector, &w, &p, &left, &right, 1, scratch);
+        }
+        else
+        {
+            waveVector.setWave(w);
+            waveVector.setFrequency(p);
+            left = waveVector.getNextSample<Kernel>();
+        }
+
+        auto g = gain->getNextValue();
+        left *= g;
+        right = isStereo() ? right * g : left;
     }
 
-    //==============================================================================
+    // the block paths (renderWave, unison, the lanes) all read it off the vector
+    void setInterpolation(TableInterpolation::Kernel kernel)
+    {
+        waveVector.setInterpolation(kernel);
+    }
 
-    WaveTableVector& getWaveVector()
+    TableInterpolation::Kernel getInterpolation() const
     {
-        return waveVector;
+        return waveVector.getInterpolation();
+    }
+
+    /*
+        block version of getNextSample(), the lfo / envelope blocks this oscillator reads have to be rendered already.
+        right only gets written when isStereo() (unison with some spread), otherwise everything is in left.
+        scratch is only used by the unison stack
+    */
+    void renderNextBlock(float* left, float* right, int numSamples, UnisonStack::Scratch& scratch)
+    {
+        renderParams(numSamples);
+        renderWave(left, right, numSamples, scratch);
+        applyGain(left, right, numSamples);
+    }
+
+    // the wavetable part, after renderParams(). The lane engine only calls this for what it can't do itself (unison, bank crossfades)
+    void renderWave(float* left, float* right, int numSamples, UnisonStack::Scratch& scratch)
+    {
+        if (isUnison())
+            unison.render(waveVector, getWaveBlock(), getPitchBlock(), left, isStereo() ? right : nullptr, numSamples, scratch);
+        else
+            waveVector.renderNextBlock(left, getWaveBlock(), getPitchBlock(), numSamples);
+    }
+
+    bool isUnison() const
+    {
+        return unison.getNumVoices() > 1;
+    }
+
+    bool isStereo() const
+    {
+        return unison.isStereo();
+    }
+
+    // the lane engine (VoiceLanes) does the wavetable part itself, so the param and gain steps are separate too
+    void renderParams(int numSamples)
+    {
+        jassert(numSamples <= controlBlock.getNumSamples());
+
+        if (controlTicks != nullptr && ! controlTicks->isAudioRate())
+        {
+            jassert(numSamples == controlTicks->numSamples);
+
+            // gain doesn't need more than a straight line, pitch / wave use whatever the patch picked
+            auto* ticks = controlBlock.getWritePointer(tickControl);
+            wave->getNextTicks(ticks, *controlTicks, controlBlock.getWritePointer(waveControl), controlTicks->interpolation);
+            pitch->getNextTicks(ticks, *controlTicks, controlBlock.getWritePointer(pitchControl), controlTicks->interpolation);
+            gain->getNextTicks(ticks, *controlTicks, controlBlock.getWritePointer(gainControl), ControlTicks::linear);
+            return;
+        }
+
+        wave->getNextBlock(controlBlock.getWritePointer(waveControl), numSamples);
+        pitch->getNextBlock(controlBlock.getWritePointer(pitchControl), numSamples);
+        gain->getNextBlock(controlBlock.getWritePointer(gainControl), numSamples);
+    }
+
+    // the voice's tick layout, renderParams() works at control rate whenever it isn't audio rate
+    void setControlTicks(const ControlTicks* ticks)
+    {
+        controlTicks = ticks;
+    }
+
+    void resetControlInterpolation()
+    {
+        gain->resetInterpolation();
+        pitch->resetInterpolation();
+        wave->resetInterpolation();
+    }
+
+    void applyGain(float* left, float* right, int numSamples)
+    {
+        FloatVectorOperations::multiply(left, controlBlock.getReadPointer(gainControl), numSamples);
+
+        if (isStereo())
+            FloatVectorOperations::multiply(right, controlBlock.getReadPointer(gainControl), numSamples);
+    }
+
+    const float* getWaveBlock() const
+    {
+        return controlBlock.getReadPointer(waveControl);
     }
 
-    void loadTables(StringRef filePath)
+    const float* getPitchBlock() const
     {
-        waveVector.loadTables(filePath);
+        return controlBlock.getReadPointer(pitchControl);
     }
 
-    void loadTableFromBuffer(AudioBuffer<float>& waveBuffer)
+    //==============================================================================
+
+    WaveTableVector& getWaveVector()
     {
-        waveVector.loadTableFromBuffer(waveBuffer);
+        return waveVector;
     }
 
     void update(float g, float gLFOScale, float gEnvScale, float w, float wLFOScale, float wEnvScale, float p, float pLFOScale, float pEnvScale)
@@ -114,6 +210,22 @@ public:
 
     }
 
+    void updateUnison(int numVoices, float detuneCents, float spread, float blend, float phaseRandom)
+    {
+        unison.setParameters(numVoices, detuneCents, spread, blend, phaseRandom);
+    }
+
+    // for changing one of them on its own (GayVoice::setParameter)
+    GayParam* getParam(GayParam::ParamType pType)
+    {
+        if (pType == GayParam::gain)
+            return gain.get();
+        if (pType == GayParam::wave)
+            return wave.get();
+
+        return pitch.get();
+    }
+
     void assignLFO(WaveTable* mLFO, GayParam::ParamType pType)
     {
         using GayType = GayParam::ParamType;
@@ -159,7 +271,19 @@ public:
             pitch->setNoEnv();
     }
 private:
+    enum ControlChannel
+    {
+        waveControl,
+        pitchControl,
+        gainControl,
+        tickControl,    // scratch for one param's ticks at control rate
+        numControls
+    };
+
     WaveTableVector waveVector;
+    UnisonStack unison;
+    AudioBuffer<float> controlBlock; // per block values of the three params
+    const ControlTicks* controlTicks = nullptr;
     double glideTime = 0.1;
     std::unique_ptr<GayParam> gain, wave, pitch;
 
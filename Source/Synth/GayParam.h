@@ -12,6 +12,7 @@
 #include <JuceHeader.h>
 #include "../WaveTable/WaveTable.h"
 #include "GayADSR.h"
+#include "ControlRate.h"
 
 class GayParam
 {
@@ -120,12 +121,115 @@ public:
         }
     }
 
+    /*
+        Same maths as getNextValue() for a whole block at once.
+        The lfo / envelope values come from their block buffers, so the voice has to render those first (GayVoice::renderControls).
+        Each step is kept in the same order as the per sample version so the two come out identical
+    */
+    void getNextBlock(float* dest, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        int i = 0;
+        while (i < numSamples && value.isSmoothing())
+            dest[i++] = value.getNextValue();
+
+        if (i < numSamples)
+            FloatVectorOperations::fill(dest + i, value.getTargetValue(), numSamples - i);
+
+        applyModulation(dest, numSamples);
+
+        val = dest[numSamples - 1];
+    }
+
+    /*
+        Control rate version of getNextBlock(): one value per tick into ticks (the lfo / envelope block buffers hold one
+        value per tick at control rate, see GayVoice::renderControlTicks). Anything given a dest gets them spread back
+        over the samples too
+    */
+    void getNextTicks(float* ticks, const ControlTicks& info, float* dest = nullptr,
+                      ControlTicks::Interpolation interpolation = ControlTicks::linear)
+    {
+        if (info.numTicks <= 0)
+            return;
+
+        for (int t = 0; t < info.numTicks; ++t)
+            ticks[t] = value.skip(info.getTickLength(t));
+
+        applyModulation(ticks, info.numTicks);
+        val = ticks[info.numTicks - 1];
+
+        if (dest != nullptr)
+            interpolator.process(ticks, info, dest, interpolation);
+    }
+
+    // getNextValue() for something ticked at control rate, the smoothing moves on numSamples at once
+    float getNextValue(int numSamples)
+    {
+        if (numSamples > 1)
+            value.skip(numSamples - 1);
+
+        return getNextValue();
+    }
+
+    void resetInterpolation()
+    {
+        interpolator.reset();
+    }
+
     float getCurrentValue()
     {
         return val;
     }
 
 private:
+    // the modulation half of getNextBlock(), dest already holds the smoothed value. Works the same on ticks
+    void applyModulation(float* dest, int numSamples)
+    {
+        int i = 0;
+        auto* lfoBlock = hasLFO ? lfo->getBlockBuffer() : nullptr;
+        auto* envBlock = hasEnv ? env->getBlockBuffer() : nullptr;
+
+        if (type == gain)
+        {
+            if (hasLFO)
+                for (i = 0; i < numSamples; ++i)
+                    dest[i] = dest[i] + (lfoBlock[i] * lfoScale);
+
+            if (hasEnv)
+                for (i = 0; i < numSamples; ++i)
+                    dest[i] = dest[i] * (envBlock[i] * envScale);
+        }
+        else if (type == pitch)
+        {
+            for (i = 0; i < numSamples; ++i)
+                dest[i] += (offset * dest[i]);
+
+            if (hasLFO)
+                for (i = 0; i < numSamples; ++i)
+                    dest[i] = dest[i] + (dest[i] * lfoBlock[i] * lfoScale);
+
+            if (hasEnv)
+                for (i = 0; i < numSamples; ++i)
+                    dest[i] = dest[i] + (dest[i] * envBlock[i] * envScale);
+        }
+        else if (type == wave)
+        {
+            if (hasLFO)
+                for (i = 0; i < numSamples; ++i)
+                    dest[i] = dest[i] + (lfoBlock[i] * lfoScale);
+
+            if (hasEnv)
+                for (i = 0; i < numSamples; ++i)
+                    dest[i] = dest[i] + (envBlock[i] * envScale);
+
+            for (i = 0; i < numSamples; ++i)
+                if (dest[i] > 1.f)
+                    dest[i] = dest[i] - 1.f;
+        }
+    }
+
     WaveTable* lfo;
     GayADSR* env;
     bool hasLFO = false;
@@ -135,4 +239,5 @@ private:
     float offset = 0.f; // only used in pitch right now, must separate from note on pitch msg. (do i have to do this?)
     float lfoScale = 1.f, envScale = 1.f; // scaling modulator values
     ParamType type;
+    ControlInterpolator interpolator;
 };
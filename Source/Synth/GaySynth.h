@@ -12,36 +12,79 @@
 #include <JuceHeader.h>
 #include "../Processor/PluginProcessor.h"
 #include "GayVoice.h"
+#include "VoiceRenderPool.h"
+#include "VoiceAllocator.h"
+#include "../WaveTable/BankSwap.h"
 
 class GaySynth : public MPESynthesiser
 {
 public:
-    static constexpr size_t maxNumVoices = 4;
+    static constexpr int maxPolyphony = 128;
+    static constexpr int defaultPolyphony = 5; // what the synth has always had, the golden references are rendered with it
 
-    GaySynth() 
+    GaySynth() : voiceArena(::operator new (sizeof(GayVoice) * (size_t)maxPolyphony, std::align_val_t(alignof(GayVoice))))
     {
-        for (size_t i = 0; i <= maxNumVoices; ++i)
-        {
-            addVoice(new GayVoice());
-        }
+        // everything that holds a voice is sized for the most there can ever be, so building one never reallocates under the audio thread
+        voices.ensureStorageAllocated(maxPolyphony);
+        laneVoices.ensureStorageAllocated(maxPolyphony);
+        laneLengths.ensureStorageAllocated(maxPolyphony);
+        laneBatch.ensureStorageAllocated(maxPolyphony * 2);
+        parallelVoices.ensureStorageAllocated(maxPolyphony);
+
+        buildVoices(defaultPolyphony);
+        setPolyphony(defaultPolyphony);
 
         setVoiceStealingEnabled(true);
     }
-    ~GaySynth() {}
+
+    ~GaySynth()
+    {
+        // the voices belong to voiceArena, not the OwnedArray, so they're destroyed in place and let go of without deleting
+        const ScopedLock sl(voicesLock);
+
+        for (auto* v : voices)
+            v->~MPESynthesiserVoice();
+
+        voices.clear(false);
+    }
+
+    enum class EngineMode
+    {
+        perVoice,   // every voice renders itself
+        lanes,      // the oscillators of all active voices run side by side in simd lanes, see VoiceLanes
+        parallel    // groups of voices render on VoiceRenderPool's worker threads
+    };
 
     void prepare(dsp::ProcessSpec& spec) noexcept
     {
         setCurrentPlaybackSampleRate(spec.sampleRate);
 
+        // once, a render could still be using it if prepare got called again
+        if (renderScratch == nullptr)
+            renderScratch.reset(new GayVoice::RenderScratch[(size_t)VoiceRenderPool::maxParticipants]);
+
         for (auto* v : voices)
         {
+            dynamic_cast<GayVoice*> (v)->setRenderScratch(renderScratch.get());
             dynamic_cast<GayVoice*> (v)->prepare(spec);
+            dynamic_cast<GayVoice*> (v)->setReferenceQuality(referenceQuality);
+            dynamic_cast<GayVoice*> (v)->setInterpolation(getInterpolation());
         }
 
+        // every group gets its own slice of channels, groups are summed into the output afterwards
+        groupChannels = jlimit(1, 8, (int)spec.numChannels);
+        groupBuffer.setSize(maxGroups * groupChannels, jmax(1, (int)spec.maximumBlockSize));
+
+        bankFadeLength = roundToInt(spec.sampleRate * 0.02); // 20ms, long enough that a swap doesn't click
+
+        lastSpec = spec;
+        isPrepared = true;
     }
 
     void update(AudioProcessorValueTreeState& apvts)
     {
+        setPolyphony((int)apvts.getRawParameterValue("Polyphony")->load());
+
         for (int i = 0; i < getNumVoices(); i++)
         {
             if ((myVoice = dynamic_cast<GayVoice*>(getVoice(i))))
@@ -51,12 +94,584 @@ public:
         }
     }
 
+    // the part of update() one group of parameters feeds, see GayVoice::getParamGroup
+    void updateGroup(GayVoice::ParamGroup group, AudioProcessorValueTreeState& apvts)
+    {
+        if (group == GayVoice::ParamGroup::polyphony)
+        {
+            setPolyphony((int)apvts.getRawParameterValue("Polyphony")->load());
+            return;
+        }
+
+        for (int i = 0; i < getNumVoices(); i++)
+        {
+            if ((myVoice = dynamic_cast<GayVoice*>(getVoice(i))))
+            {
+                myVoice->updateGroup(group, apvts);
+            }
+        }
+    }
+
+    // one parameter on every voice without a full update(), see GayVoice::getParamTarget
+    void setParameter(GayVoice::ParamTarget target, float value)
+    {
+        for (int i = 0; i < getNumVoices(); i++)
+        {
+            if ((myVoice = dynamic_cast<GayVoice*>(getVoice(i))))
+            {
+                myVoice->setParameter(target, value);
+            }
+        }
+    }
+
+    /*
+        Queues a bank for one oscillator's voices, any thread but the audio one. They pick it up at the start of the
+        next block (beginBlock) and fade over to it, nothing here waits on the audio thread. See BankSwap
+    */
+    void publishBank(int oscNum, WavetableBank::Ptr bank)
+    {
+        bankSwaps[oscNum == 1 ? 0 : 1].publish(bank);
+    }
+
+    /*
+        Audio thread, before anything renders. Swaps in whatever bank was published since the last block.
+        Takes no lock: it only walks the voices buildVoices has finished (numBuiltVoices), straight out of the arena,
+        and voices are only ever added on the end
+    */
+    void beginBlock(int numSamples)
+    {
+        syncNewVoices();
+
+        for (int osc = 1; osc <= 2; ++osc)
+        {
+            bankSwaps[osc == 1 ? 0 : 1].beginBlock(numSamples, bankFadeLength,
+                [this, osc]
+                {
+                    for (int i = 0; i < numSyncedVoices; ++i)
+                        getArenaVoice(i)->getTable(osc).finishFade();
+                },
+                [this, osc](const WavetableBank* bank, int fadeLength)
+                {
+                    for (int i = 0; i < numSyncedVoices; ++i)
+                        getArenaVoice(i)->getTable(osc).startFade(bank, fadeLength);
+                });
+        }
+
+        // the kernel only ever changes here, so never halfway through a block
+        auto kernel = getInterpolation();
+
+        for (int i = 0; i < numSyncedVoices; ++i)
+            getArenaVoice(i)->setInterpolation(kernel);
+    }
+
+    /*
+        Voices live side by side in one block (voiceArena) that's allocated up front for maxPolyphony of them.
+        Building a voice constructs it into its slot and prepares it, which allocates, so this is message thread only.
+        A new voice plays the sine bank until the audio thread moves it on to voice 0's tables (syncNewVoices), it
+        can't get a note before then. Voices are never torn down again until the synth goes.
+        Use this instead of addVoice / reduceNumVoices, those assume the voices came from new.
+    */
+    void buildVoices(int numVoices)
+    {
+        numVoices = jlimit(1, maxPolyphony, numVoices);
+
+        while (getNumVoices() < numVoices)
+        {
+            auto* voice = new (getVoiceSlot(getNumVoices())) GayVoice();
+            voice->setOversamplingFilter(linearPhaseOversampling);
+
+            if (isPrepared)
+            {
+                voice->setRenderScratch(renderScratch.get());
+                voice->prepare(lastSpec);
+            }
+
+            voice->setReferenceQuality(referenceQuality);
+            voice->setInterpolation(getInterpolation());
+
+            addVoice(voice); // takes voicesLock itself
+
+            // from here on the audio thread picks it up
+            numBuiltVoices.store(getNumVoices(), std::memory_order_release);
+        }
+    }
+
+    /*
+        Swaps every voice's oversamplers between polyphase IIR and linear phase FIR, message thread (it allocates).
+        The new ones are all built first without the lock, the lock only covers swapping the pointers over, and the
+        old ones get freed after it's let go. Voices only touch their oversamplers while rendering or starting a note
+        (both under voicesLock, update() just asks for a factor), so nothing can still be using the old ones by then
+    */
+    void setOversamplingFilter(bool useLinearPhase)
+    {
+        if (linearPhaseOversampling == useLinearPhase)
+            return;
+
+        // only the message thread builds voices, so this is every voice there is
+        auto numVoices = numBuiltVoices.load();
+        std::vector<GayVoice::Oversamplers> spare((size_t)numVoices);
+
+        for (int i = 0; i < numVoices; ++i)
+            spare[(size_t)i] = getArenaVoice(i)->makeOversamplers(useLinearPhase);
+
+        {
+            const ScopedLock sl(voicesLock);
+            linearPhaseOversampling = useLinearPhase;
+
+            for (int i = 0; i < numVoices; ++i)
+                getArenaVoice(i)->swapOversamplers(spare[(size_t)i], useLinearPhase);
+        }
+    }
+
+    // what the processor should report for the "Oversampling" choice, only the linear phase filters have a fixed latency
+    int getOversamplingLatency(int factorIndex) const
+    {
+        if (! linearPhaseOversampling || voices.isEmpty())
+            return 0;
+
+        return roundToInt(dynamic_cast<GayVoice*> (voices.getUnchecked(0))->getOversamplingLatency(factorIndex));
+    }
+
+    /*
+        How many of the built voices notes can go to. Audio thread (it's called from update()), or before playback
+        starts, since it moves new voices on to their tables (syncNewVoices).
+        Can't go past what buildVoices has built, voices above the limit are cut off and left alone until it comes back up
+    */
+    void setPolyphony(int numVoices)
+    {
+        const ScopedLock sl(voicesLock);
+
+        // only voices that are on the right tables can take notes
+        syncNewVoices();
+        polyphony = jlimit(1, jmax(1, numSyncedVoices), numVoices);
+
+        if (allocator.getNumVoices() != polyphony)
+            allocator.setNumVoices(polyphony);
+
+        for (int i = polyphony; i < voices.size(); ++i)
+        {
+            if (voices.getUnchecked(i)->isActive())
+            {
+                dynamic_cast<GayVoice*> (voices.getUnchecked(i))->park();
+            }
+        }
+    }
+
+    int getPolyphony() const
+    {
+        return polyphony;
+    }
+
+    /*
+        Reference quality pins rendering to the plain per sample scalar path, one voice after another.
+        Offline renders and the golden null tests use it, anything faster (and not bit exact) must stay off while it's set
+    */
+    void setReferenceQuality(bool shouldUseReference)
+    {
+        referenceQuality = shouldUseReference;
+
+        for (auto* v : voices)
+        {
+            dynamic_cast<GayVoice*> (v)->setReferenceQuality(referenceQuality);
+        }
+    }
+
+    bool isReferenceQuality() const
+    {
+        return referenceQuality;
+    }
+
+    /*
+        How the oscillators read between table samples (TableInterpolation), one kernel per quality mode. Both
+        default to linear: gpc_golden holds normal quality to the reference renders, so the two only part ways
+        when someone picks a kernel on purpose. Any thread, the voices pick it up in beginBlock.
+        Every render path dispatches on it once a block, none of the sample loops branch on it
+    */
+    void setInterpolation(bool forReferenceQuality, TableInterpolation::Kernel kernel)
+    {
+        (forReferenceQuality ? referenceInterpolation : realtimeInterpolation).store(kernel);
+    }
+
+    // the kernel for the quality mode that's on now
+    TableInterpolation::Kernel getInterpolation() const
+    {
+        return getInterpolation(referenceQuality);
+    }
+
+    TableInterpolation::Kernel getInterpolation(bool forReferenceQuality) const
+    {
+        return (forReferenceQuality ? referenceInterpolation : realtimeInterpolation).load();
+    }
+
+    // lanes is opt in, it isn't sample identical to the per voice engine (one phase per oscillator instead of per table)
+    // parallel starts the worker threads the first time it's picked, so set it from the message thread
+    void setEngineMode(EngineMode newMode)
+    {
+        if (newMode == EngineMode::parallel && renderPool->getNumWorkers() == 0)
+            setNumRenderThreads(VoiceRenderPool::getDefaultNumWorkers());
+
+        engineMode = newMode;
+    }
+
+    EngineMode getEngineMode() const
+    {
+        return engineMode;
+    }
+
+    /*
+        Worker threads for EngineMode::parallel, on top of the audio thread (which always takes part). Message thread only.
+        The new threads start in a pool of their own, which gets swapped in with an atomic pointer. This then waits
+        (the audio thread never does) until renderParallel has let go of the old pool, and joins its threads here
+    */
+    void setNumRenderThreads(int numThreads)
+    {
+        auto newPool = std::make_unique<VoiceRenderPool>();
+        newPool->start(numThreads);
+
+        activePool.store(newPool.get());
+
+        // a render that started before the swap might still be on the old pool, one that finishes after it is the last
+        auto epoch = poolEpoch.load();
+        while (poolInUse.load() && poolEpoch.load() == epoch)
+            Thread::sleep(1);
+
+        std::swap(renderPool, newPool);
+        newPool.reset(); // the old pool, its threads get joined here
+    }
+
+    int getNumRenderThreads() const
+    {
+        return renderPool->getNumWorkers();
+    }
+
 private:
+    /*
+        Raw storage for maxPolyphony voices in one contiguous block. HeapBlock only gets malloc's alignment, a voice can
+        need more than that (anything in it is free to be over aligned), so this comes from the aligned operator new
+    */
+    struct ArenaDeleter
+    {
+        void operator() (void* arena) const noexcept
+        {
+            ::operator delete (arena, std::align_val_t(alignof(GayVoice)));
+        }
+    };
+
+    std::unique_ptr<void, ArenaDeleter> voiceArena;
+
+    // sizeof is always a multiple of alignof, so every slot is aligned once the first one is
+    void* getVoiceSlot(int index) const
+    {
+        return static_cast<char*>(voiceArena.get()) + sizeof(GayVoice) * (size_t)index;
+    }
+
+    GayVoice* getArenaVoice(int index) const
+    {
+        return std::launder(static_cast<GayVoice*>(getVoiceSlot(index)));
+    }
+
+    std::atomic<int> numBuiltVoices { 0 }; // buildVoices -> audio thread
+    int numSyncedVoices = 0;               // audio thread (or before playback starts), never more than numBuiltVoices
+
+    /*
+        Moves voices built since the last call on to whatever voice 0 is reading, fade and all. Only the thread that
+        runs beginBlock changes what a voice reads, so this runs there too: beginBlock and setPolyphony
+    */
+    void syncNewVoices()
+    {
+        auto numBuilt = numBuiltVoices.load(std::memory_order_acquire);
+
+        for (; numSyncedVoices < numBuilt; ++numSyncedVoices)
+            if (numSyncedVoices > 0)
+                getArenaVoice(numSyncedVoices)->copyTablesFrom(*getArenaVoice(0));
+    }
+
+    int polyphony = 1;
+    dsp::ProcessSpec lastSpec { 44100.0, 512, 2 };
+    bool isPrepared = false;
+
+    bool referenceQuality = false;
+    bool linearPhaseOversampling = false;
+    std::atomic<TableInterpolation::Kernel> realtimeInterpolation { TableInterpolation::Kernel::linear };
+    std::atomic<TableInterpolation::Kernel> referenceInterpolation { TableInterpolation::Kernel::linear };
+
+    std::array<BankSwap, 2> bankSwaps; // one per oscillator
+    int bankFadeLength = 882;
+    std::atomic<EngineMode> engineMode { EngineMode::perVoice };
+
+    static constexpr int voicesPerGroup = 4;
+    static constexpr int maxGroups = maxPolyphony / voicesPerGroup;
+
+    // one piece of work = one group of voices rendered into that group's channels of groupBuffer
+    struct GroupJob : public VoiceRenderPool::Job
+    {
+        GroupJob(GaySynth& s) : synth(s) {}
+
+        void perform(int group, int participant) override
+        {
+            synth.renderGroup(group, numSamples, synth.renderScratch[(size_t)participant]);
+        }
+
+        GaySynth& synth;
+        int numSamples = 0;
+    };
+
+    std::unique_ptr<VoiceRenderPool> renderPool = std::make_unique<VoiceRenderPool>(); // message thread
+    std::atomic<VoiceRenderPool*> activePool { renderPool.get() };  // what renderParallel runs on
+    std::atomic<bool> poolInUse { false };                          // renderParallel is between loading activePool and done with it
+    std::atomic<uint32> poolEpoch { 0 };                            // goes up every time it's done
+    GroupJob groupJob { *this };
+
+    // one per pool participant, [0] is the audio thread's (every engine uses it, the parallel one hands the rest to
+    // its workers). Allocated in prepare, so nothing needs thread_local storage, which a plugin gets from malloc
+    std::unique_ptr<GayVoice::RenderScratch[]> renderScratch;
+    Array<GayVoice*> parallelVoices;
+    AudioBuffer<float> groupBuffer;
+    float* const* groupChannelPointers = nullptr;
+    int groupChannels = 2;
+    int numGroupChannelsUsed = 0;
+
+    VoiceLanes voiceLanes;
+    Array<GayVoice*> laneVoices;
+    Array<int> laneLengths;
+    Array<VoiceLanes::Lane> laneBatch;
+    std::array<LadderLanes::Lane, (size_t)maxPolyphony * 2> filterBatch; // up to two channels a voice
     GayVoice* myVoice; // This is used to check the type of voice being used by the synth ( and then to send the apvts to it )
 
+    //==============================================================================
+    // notes only ever go to the first `polyphony` voices, VoiceAllocator picks which without searching them
+    static_assert(maxPolyphony <= VoiceAllocator::maxVoices, "the allocator has a slot for every voice");
+
+    VoiceAllocator allocator;
+    mutable int allocatedSlot = -1; // what findFreeVoice() last handed out, noteAdded() tells the allocator
+
+    MPESynthesiserVoice* findFreeVoice(MPENote noteToFindVoiceFor, bool stealIfNoneAvailable) const override
+    {
+        auto slot = allocator.getFreeVoice();
+
+        if (slot < 0 && stealIfNoneAvailable)
+            slot = allocator.findVoiceToSteal(noteToFindVoiceFor.initialNote);
+
+        allocatedSlot = slot;
+        return slot >= 0 ? voices.getUnchecked(slot) : nullptr;
+    }
+
+    MPESynthesiserVoice* findVoiceToSteal(MPENote noteToStealVoiceFor = MPENote()) const override
+    {
+        auto slot = allocator.findVoiceToSteal(noteToStealVoiceFor.isValid() ? (int)noteToStealVoiceFor.initialNote : -1);
+        return slot >= 0 ? voices.getUnchecked(slot) : nullptr;
+    }
+
+    /*
+        MPESynthesiser finds the voice and starts it, these just keep the allocator in step. Note offs still go through
+        MPESynthesiser's own search for the voice playing the note (it's the only thing that can change a voice's note)
+    */
+    void noteAdded(MPENote newNote) override
+    {
+        allocatedSlot = -1;
+        MPESynthesiser::noteAdded(newNote);
+
+        if (allocatedSlot >= 0)
+            allocator.noteStarted(allocatedSlot, newNote.initialNote, newNote.noteID);
+    }
+
+    void noteReleased(MPENote finishedNote) override
+    {
+        MPESynthesiser::noteReleased(finishedNote);
+        syncSlot(allocator.findSlot(finishedNote.initialNote, finishedNote.noteID));
+    }
+
+    void noteKeyStateChanged(MPENote changedNote) override
+    {
+        MPESynthesiser::noteKeyStateChanged(changedNote);
+        syncSlot(allocator.findSlot(changedNote.initialNote, changedNote.noteID));
+    }
+
+    // which heap a voice belongs in from its key, or out altogether once it's finished
+    void syncSlot(int slot)
+    {
+        if (slot < 0)
+            return;
+
+        auto* voice = voices.getUnchecked(slot);
+
+        if (! voice->isActive())
+        {
+            allocator.voiceFinished(slot);
+            return;
+        }
+
+        switch (voice->getCurrentlyPlayingNote().keyState)
+        {
+        case MPENote::off:          allocator.setPool(slot, VoiceAllocator::Pool::released); break;
+        case MPENote::sustained:    allocator.setPool(slot, VoiceAllocator::Pool::sustained); break;
+        default:                    allocator.setPool(slot, VoiceAllocator::Pool::held); break;
+        }
+
+        if (allocator.getPool(slot) == VoiceAllocator::Pool::released)
+            allocator.setLevel(slot, static_cast<GayVoice*>(voice)->getLevel());
+    }
+
+    // after every sub block: voices that finished go back on the free stack, released ones get their new level
+    void syncAllocator()
+    {
+        for (int i = allocator.getNumActive(); --i >= 0;) // backwards, a finished slot gets swapped with the last one
+            syncSlot(allocator.getActive(i));
+    }
+
     void renderNextSubBlock(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override
     {
-        MPESynthesiser::renderNextSubBlock(outputAudio, startSample, numSamples);
+        if (engineMode == EngineMode::lanes && ! referenceQuality)
+            renderLanes(outputAudio, startSample, numSamples);
+        else if (engineMode == EngineMode::parallel && ! referenceQuality)
+            renderParallel(outputAudio, startSample, numSamples);
+        else
+            MPESynthesiser::renderNextSubBlock(outputAudio, startSample, numSamples);
+
+        syncAllocator();
+    }
+
+    /*
+        Every active voice does its controls, then all their oscillators go through the lanes together,
+        then each voice mixes, filters and adds itself to the output in voice order (same order the per voice engine uses)
+    */
+    void renderLanes(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+    {
+        const ScopedLock sl(voicesLock);
+
+        laneVoices.clearQuick();
+        laneLengths.clearQuick();
+        auto chunkSize = numSamples;
+
+        for (auto* v : voices)
+        {
+            if (v->isActive())
+            {
+                if (auto* voice = dynamic_cast<GayVoice*>(v))
+                {
+                    laneVoices.add(voice);
+                    laneLengths.add(0);
+                    chunkSize = jmin(chunkSize, voice->getMaxBlockSize());
+                }
+            }
+        }
+
+        if (laneVoices.isEmpty() || chunkSize <= 0)
+            return;
+
+        for (int done = 0; done < numSamples; done += chunkSize)
+        {
+            auto n = jmin(chunkSize, numSamples - done);
+            laneBatch.clearQuick();
+
+            for (int i = 0; i < laneVoices.size(); ++i)
+            {
+                if (! laneVoices[i]->isActive())
+                    continue; // finished in an earlier chunk
+
+                auto length = laneVoices[i]->renderLaneControls(n, renderScratch[0]);
+                laneLengths.set(i, length);
+
+                for (int osc = 1; osc <= 2; ++osc)
+                    if (laneVoices[i]->usesLane(osc))
+                        laneBatch.add(laneVoices[i]->getLane(osc, length));
+            }
+
+            voiceLanes.process(laneBatch.getRawDataPointer(), laneBatch.size(), getInterpolation());
+
+            // every voice's filter goes through the ladder lanes together too
+            int numFilterLanes = 0;
+            for (int i = 0; i < laneVoices.size(); ++i)
+            {
+                if (laneVoices[i]->isActive())
+                    numFilterLanes += laneVoices[i]->renderLaneMix(laneLengths[i], n, filterBatch.data() + numFilterLanes);
+            }
+
+            renderScratch[0].ladder.process(filterBatch.data(), numFilterLanes);
+
+            for (int i = 0; i < laneVoices.size(); ++i)
+            {
+                if (laneVoices[i]->isActive())
+                    laneVoices[i]->renderLaneOutput(outputAudio, startSample + done, n);
+            }
+        }
+    }
+
+    /*
+        Active voices are split into fixed groups of voicesPerGroup in voice order, the pool renders each group into
+        its own channels, then the groups are added into the output in group order. Which thread did which group
+        doesn't change the result, so renders stay repeatable whatever the thread count (they aren't bit identical
+        to the per voice engine though, the voices get summed in a different order)
+    */
+    void renderParallel(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+    {
+        const ScopedLock sl(voicesLock);
+
+        parallelVoices.clearQuick();
+
+        for (auto* v : voices)
+        {
+            if (v->isActive())
+            {
+                if (auto* voice = dynamic_cast<GayVoice*>(v))
+                {
+                    parallelVoices.add(voice);
+                }
+            }
+        }
+
+        auto chunkSize = groupBuffer.getNumSamples();
+        numGroupChannelsUsed = jmin(outputAudio.getNumChannels(), groupChannels);
+
+        if (parallelVoices.isEmpty() || numGroupChannelsUsed <= 0 || ! isPrepared)
+            return;
+
+        auto numGroups = (parallelVoices.size() + voicesPerGroup - 1) / voicesPerGroup;
+
+        // fetched here so the workers never touch the buffer object itself, only its channels
+        groupChannelPointers = groupBuffer.getArrayOfWritePointers();
+
+        // the pool for this sub block, setNumRenderThreads waits for poolInUse / poolEpoch before getting rid of it
+        poolInUse.store(true);
+        auto* pool = activePool.load();
+
+        for (int done = 0; done < numSamples; done += chunkSize)
+        {
+            auto n = jmin(chunkSize, numSamples - done);
+            groupJob.numSamples = n;
+
+            pool->run(groupJob, numGroups);
+
+            for (int group = 0; group < numGroups; ++group)
+            {
+                for (int channel = 0; channel < numGroupChannelsUsed; ++channel)
+                {
+                    outputAudio.addFrom(channel, startSample + done, groupBuffer, group * groupChannels + channel, 0, n);
+                }
+            }
+        }
+
+        ++poolEpoch;
+        poolInUse.store(false);
+    }
+
+    // runs on whichever thread claimed the group
+    void renderGroup(int group, int numSamples, GayVoice::RenderScratch& scratch)
+    {
+        auto* const* channels = groupChannelPointers + group * groupChannels;
+
+        for (int channel = 0; channel < numGroupChannelsUsed; ++channel)
+            FloatVectorOperations::clear(channels[channel], numSamples);
+
+        // refers to the group's channels, small channel counts don't allocate
+        AudioBuffer<float> groupOutput(channels, numGroupChannelsUsed, numSamples);
+
+        auto end = jmin(parallelVoices.size(), (group + 1) * voicesPerGroup);
+
+        for (int i = group * voicesPerGroup; i < end; ++i)
+        {
+            if (parallelVoices.getUnchecked(i)->isActive()) // may have finished in an earlier chunk
+                parallelVoices.getUnchecked(i)->renderNextBlock(groupOutput, 0, numSamples, scratch);
+        }
     }
 };
- 
\ No newline at end of file
@@ -13,6 +13,8 @@
 #include "GaySynth.h"
 #include "GayOscillator.h"
 #include "GayADSR.h"
+#include "VoiceLanes.h"
+#include "LadderLanes.h"
 #include "../Processor/PluginProcessor.h"
 
 
@@ -25,6 +27,9 @@ public:
         filtFreq = std::make_unique<GayParam>(GayParam::ParamType::pitch); // rename this to be freq?
         filtDrive = std::make_unique<GayParam>(GayParam::ParamType::gain);
         filtRes = std::make_unique<GayParam>(GayParam::ParamType::gain); // rename this type to be normalized?
+
+        osc1.setControlTicks(&controlTicks);
+        osc2.setControlTicks(&controlTicks);
     }
 
     void initMods()
@@ -49,13 +54,50 @@ public:
 
 
     }
+
+    /*
+        Working space for rendering a voice, nothing in it carries over from one block to the next (the filter state
+        is in ladderStates, the unison phases in the stacks). It's 64 byte aligned and too big to want one per voice,
+        so the synth keeps one per thread that renders voices and hands in the right one (GaySynth::renderScratch)
+    */
+    struct RenderScratch
+    {
+        LadderLanes ladder;
+        UnisonStack::Scratch unison;
+    };
+
+    // the audio thread's scratch, what renderNextBlock() and stealing use. Set by the synth when it prepares
+    void setRenderScratch(RenderScratch* scratch)
+    {
+        audioThreadScratch = scratch;
+    }
+
     //==============================================================================
     void prepare(const juce::dsp::ProcessSpec& spec)
     {
         prepareMods(spec.sampleRate);
 
-        osc1.prepare(spec.sampleRate);
-        osc2.prepare(spec.sampleRate);
+        osc1.prepare(spec.sampleRate, (int)spec.maximumBlockSize);
+        osc2.prepare(spec.sampleRate, (int)spec.maximumBlockSize);
+
+        // lfo's and envelopes render into here first, the params read their values back out of it
+        controlBuffer.setSize(numControlChannels, jmax(1, (int)spec.maximumBlockSize));
+        controlBuffer.clear();
+
+        // the voice gets filtered on its own in here before it hits the output, mono unless an oscillator has unison spread
+        voiceBuffer.setSize(2, jmax(1, (int)spec.maximumBlockSize));
+        voiceBuffer.clear();
+
+        // at control rate the modulators write one value per tick in here instead
+        tickBuffer.setSize(numModChannels, jmax(1, (int)spec.maximumBlockSize));
+        tickBuffer.clear();
+
+        // a stolen note's last couple of ms, see handOverToStealTail()
+        stealTail.setSize(2, jmax(1, (int)std::ceil(stealFadeSeconds * spec.sampleRate)));
+        stealTail.clear();
+        stealTailLength = stealTailPosition = 0;
+
+        setModBlockBuffers();
 
         filtFreq->prepare(spec.sampleRate);
         filtRes->prepare(spec.sampleRate);
@@ -65,9 +107,127 @@ public:
         filtRes->setValue(0.f);
         filtDrive->setValue(1.f);
 
-        filter.prepare(spec);
-        filter.setCutoffFrequencyHz(400.f);
-        filter.setMode(juce::dsp::LadderFilter<float>::Mode::LPF24);
+        for (auto& state : ladderStates)
+            state.reset();
+
+        // reference quality's filter, one per oversampling factor (see applyReferenceFilter())
+        for (int i = 0; i < numOversamplingFactors; ++i)
+        {
+            auto factor = (uint32)1 << (uint32)i;
+            referenceFilters[(size_t)i].prepare({ spec.sampleRate * factor, spec.maximumBlockSize * factor, 2 });
+        }
+
+        maxBlockSize = (int)spec.maximumBlockSize;
+        buildOversamplers();
+    }
+
+    /*
+        The drive in the ladder filter is the nonlinear part of the voice, so that's what gets oversampled.
+        Every factor's oversampler is built up front (they allocate) and update() just asks for one, the render
+        switches over to it (see applyOversampling()). Polyphase IIR half bands are the cheap default and have no fixed latency, the linear phase
+        FIR ones cost more and add latency (the processor reports it, see getOversamplingLatency())
+    */
+    void setOversamplingFilter(bool useLinearPhase) // message thread, only while nothing's rendering the voice
+    {
+        if (linearPhaseOversampling != useLinearPhase)
+        {
+            linearPhaseOversampling = useLinearPhase;
+            buildOversamplers();
+        }
+    }
+
+    using Oversamplers = std::array<std::unique_ptr<dsp::Oversampling<float>>, 3>; // 2x, 4x, 8x
+
+    // a set of oversamplers for this voice, built anywhere but the audio thread (they allocate). Empty until it's prepared
+    Oversamplers makeOversamplers(bool useLinearPhase) const
+    {
+        Oversamplers built;
+
+        if (maxBlockSize <= 0)
+            return built; // not prepared yet, prepare() builds them
+
+        auto type = useLinearPhase ? dsp::Oversampling<float>::filterHalfBandFIREquiripple
+                                   : dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
+
+        for (int i = 1; i < numOversamplingFactors; ++i)
+        {
+            auto& oversampler = built[(size_t)i - 1];
+            oversampler = std::make_unique<dsp::Oversampling<float>>(2, (size_t)i, type, false, useLinearPhase);
+            oversampler->initProcessing((size_t)maxBlockSize);
+        }
+
+        return built;
+    }
+
+    /*
+        setOversamplingFilter() for a voice that could be playing: swaps in oversamplers built with makeOversamplers()
+        and leaves the old ones in newOversamplers, for the caller to free. Nothing here allocates or frees, so the
+        lock it's done under is only held for a few pointer swaps (GaySynth::setOversamplingFilter)
+    */
+    void swapOversamplers(Oversamplers& newOversamplers, bool useLinearPhase)
+    {
+        std::swap(oversamplers, newOversamplers);
+        linearPhaseOversampling = useLinearPhase;
+    }
+
+    /*
+        0 is off, then 2x, 4x, 8x. Audio thread, but outside the render (update() doesn't hold the voice lock), so it
+        only asks for the factor. The oversamplers themselves are only touched under the voice lock
+    */
+    void setOversampling(int factorIndex)
+    {
+        requestedOversampling = jlimit(0, numOversamplingFactors - 1, factorIndex);
+    }
+
+    // in samples at the base rate, 0 when the factor is off or not built yet
+    float getOversamplingLatency(int factorIndex) const
+    {
+        if (factorIndex <= 0 || factorIndex >= numOversamplingFactors || oversamplers[(size_t)factorIndex - 1] == nullptr)
+            return 0.f;
+
+        return oversamplers[(size_t)factorIndex - 1]->getLatencyInSamples();
+    }
+
+    // the params read lfo / envelope values from controlBuffer at audio rate, tickBuffer at control rate
+    void setModBlockBuffers()
+    {
+        auto& modBuffer = controlTicks.isAudioRate() ? controlBuffer : tickBuffer;
+
+        if (modBuffer.getNumSamples() == 0)
+            return; // not prepared yet
+
+        lfo1->setBlockBuffer(modBuffer.getWritePointer(lfo1Channel));
+        lfo2->setBlockBuffer(modBuffer.getWritePointer(lfo2Channel));
+        lfo3->setBlockBuffer(modBuffer.getWritePointer(lfo3Channel));
+
+        env1.setBlockBuffer(modBuffer.getWritePointer(env1Channel));
+        env2.setBlockBuffer(modBuffer.getWritePointer(env2Channel));
+        env3.setBlockBuffer(modBuffer.getWritePointer(env3Channel));
+    }
+
+    // interval 1 is audio rate. Called from update(), so audio thread, nothing here allocates
+    void setControlRate(int interval, ControlTicks::Interpolation interpolation)
+    {
+        controlTicks.interpolation = interpolation;
+
+        if (controlTicks.interval != interval)
+        {
+            controlTicks.interval = jmax(1, interval);
+            setModBlockBuffers();
+            resetControlInterpolation();
+        }
+    }
+
+    void resetControlInterpolation()
+    {
+        ampInterpolator.reset();
+        osc1.resetControlInterpolation();
+        osc2.resetControlInterpolation();
+    }
+
+    void buildOversamplers()
+    {
+        oversamplers = makeOversamplers(linearPhaseOversampling);
     }
 
     void prepareMods(double sampleRate)
@@ -96,10 +256,17 @@ public:
     //==============================================================================
     void noteStarted() override
     {
+        // still sounding means the synth stole this voice, the old note fades out from stealTail under the new one
+        if (hasNote)
+            handOverToStealTail();
+
+        hasNote = true;
+
         auto velocity = getCurrentlyPlayingNote().noteOnVelocity.asUnsignedFloat();
         auto freqHz = (float)getCurrentlyPlayingNote().getFrequencyInHertz();
 
         pitch = freqHz;
+        tailSamples = 0;
 
         env1.noteOn();
         env2.noteOn();
@@ -123,6 +290,10 @@ public:
        env1.noteOff();
        env2.noteOff();
        env3.noteOff();
+
+       // no tail wanted, but going straight to silence clicks
+       if (! allowTailOff)
+           env1.fastRelease(cutOffFadeSeconds);
     }
 
     //==============================================================================
@@ -131,53 +302,577 @@ public:
     void noteKeyStateChanged() override {}
 
     //==============================================================================
+    /*
+        Rendering happens in stages over the whole block:
+            renderControls     - lfo's and envelopes sample by sample (they feed each other), then the filter params
+            renderOscillators  - each oscillator renders its params and its wavetables into its own block
+            renderVoice        - mixes the oscillators and applies the amp env into voiceBuffer
+        then the voice filters its own buffer (LadderLanes, cutoff per sample) and adds it into every output channel.
+        Once the amp env is done the voice keeps going (silence in, filter out) until what comes out of the filter is
+        silent, then it clears its note and the synth stops rendering it at all until it gets a new one.
+        Reference quality keeps the old everything-per-sample loop in place of the first three, and dsp::LadderFilter
+        in place of LadderLanes (see applyReferenceFilter())
+    */
     void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override
     {
-        auto blockWrite = outputBuffer.getArrayOfWritePointers();
+        jassert(audioThreadScratch != nullptr); // not prepared
+        renderNextBlock(outputBuffer, startSample, numSamples, *audioThreadScratch);
+    }
+
+    // the same with the scratch handed in, the parallel engine's workers call this with their own
+    void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples, RenderScratch& scratch)
+    {
+        jassert(voiceBuffer.getNumSamples() > 0); // not prepared
+
+        // host blocks bigger than the one we were prepared with get done in pieces
+        for (int done = 0; done < numSamples && voiceBuffer.getNumSamples() > 0;)
+        {
+            auto blockSize = jmin(numSamples - done, voiceBuffer.getNumSamples());
+
+            if (referenceQuality)
+            {
+                renderReference(blockSize, scratch);
+            }
+            else
+            {
+                auto numActive = renderControls(blockSize);
+                renderOscillators(numActive, scratch);
+                renderVoice(numActive, blockSize);
+            }
+
+            applyFilter(blockSize, scratch);
+            auto finished = isTailFinished(blockSize);
+            addToOutput(outputBuffer, startSample + done, blockSize);
+
+            if (finished)
+            {
+                finishNote();
+                break;
+            }
+
+            done += blockSize;
+        }
+    }
+
+    // the longest a voice keeps ringing after its amp env is done (offline renders use it to know when a note has stopped)
+    static constexpr double maxTailSeconds = 2.0;
+
+    /*
+        Call after the filter, before adding to the output. True once the amp env is done and the filtered output
+        has dropped below silenceThreshold. A tail that rings on past maxTailSeconds gets faded out over this block
+        and finished anyway (self oscillating filter)
+    */
+    bool isTailFinished(int numSamples)
+    {
+        if (env1.isActive() || stealTailPosition + numSamples < stealTailLength)
+            return false;
+
+        tailSamples += numSamples;
+
+        if (tailSamples >= (int)(maxTailSeconds * getSampleRate()))
+        {
+            for (int channel = 0; channel < numVoiceChannels; ++channel)
+                voiceBuffer.applyGainRamp(channel, 0, numSamples, 1.f, 0.f);
+
+            return true;
+        }
+
+        auto magnitude = 0.f;
+        for (int channel = 0; channel < numVoiceChannels; ++channel)
+            magnitude = jmax(magnitude, voiceBuffer.getMagnitude(channel, 0, numSamples));
+
+        return magnitude < silenceThreshold;
+    }
+
+    // back to the free list, everything that carries over between notes goes back to rest so the next note starts clean
+    void finishNote()
+    {
+        resetNoteState();
+        hasNote = false;
+        clearCurrentNote();
+    }
+
+    void resetNoteState()
+    {
+        env1.reset();
+        env2.reset();
+        env3.reset();
+        for (auto& state : ladderStates)
+            state.reset();
+
+        for (auto& filter : referenceFilters)
+            filter.reset();
+
+        for (auto& oversampler : oversamplers)
+            if (oversampler != nullptr)
+                oversampler->reset();
+
+        resetControlInterpolation();
+        tailSamples = 0;
+    }
+
+    /*
+        Stealing: rather than retrigger over whatever this voice was playing (a click), the old note gets a fast
+        release and its next stealFadeSeconds render straight into stealTail, faded to nothing by the end whatever
+        the filter is still doing. Then the voice starts the new note from rest and addToOutput() plays the tail out
+        under it. Anything left of an earlier steal goes into the new tail too
+    */
+    void handOverToStealTail()
+    {
+        auto length = stealTail.getNumSamples();
+        auto carried = jmax(0, stealTailLength - stealTailPosition);
+
+        for (int channel = 0; channel < stealTail.getNumChannels(); ++channel)
+        {
+            auto* tail = stealTail.getWritePointer(channel);
+            std::memmove(tail, tail + stealTailPosition, sizeof(float) * (size_t)carried);
+            FloatVectorOperations::clear(tail + carried, length - carried);
+        }
+
+        env1.fastRelease(stealFadeSeconds);
+        auto& scratch = *audioThreadScratch; // notes only ever start on the audio thread
+
+        for (int done = 0; done < length;)
+        {
+            auto n = jmin(length - done, voiceBuffer.getNumSamples());
+
+            if (referenceQuality)
+            {
+                renderReference(n, scratch);
+            }
+            else
+            {
+                auto numActive = renderControls(n);
+                renderOscillators(numActive, scratch);
+                renderVoice(numActive, n);
+            }
+
+            applyFilter(n, scratch);
+
+            for (int channel = 0; channel < stealTail.getNumChannels(); ++channel)
+                stealTail.addFrom(channel, done, voiceBuffer, channel % numVoiceChannels, 0, n);
+
+            done += n;
+        }
+
+        for (int channel = 0; channel < stealTail.getNumChannels(); ++channel)
+            stealTail.applyGainRamp(channel, 0, length, 1.f, 0.f);
+
+        stealTailLength = length;
+        stealTailPosition = 0;
+
+        resetNoteState();
+    }
+
+    // runs over the whole chunk even once the amp env is done, so the filter rings out
+    void applyFilter(int numSamples, RenderScratch& scratch)
+    {
+        if (referenceQuality)
+        {
+            applyReferenceFilter(numSamples);
+            return;
+        }
+
+        LadderLanes::Lane lanes[2];
+        auto numLanes = beginFilter(numSamples, lanes);
+        scratch.ladder.process(lanes, numLanes);
+        endFilter(numSamples);
+    }
+
+    /*
+        Reference quality's filter: the dsp::LadderFilter the voice had before LadderLanes, exact tanh and exp, with
+        cutoff, drive and resonance set once a block, so reference renders still sound like the original filter.
+        Oversampled the same way as the normal path
+    */
+    void applyReferenceFilter(int numSamples)
+    {
+        applyOversampling();
+
+        if (! isFiltering)
+            return;
+
+        auto block = getFilterBlock(numSamples);
+        auto& filter = referenceFilters[(size_t)oversamplingIndex];
+
+        filter.setMode(ladderMode == LadderLanes::Mode::HPF24 ? dsp::LadderFilter<float>::Mode::HPF24
+                                                              : dsp::LadderFilter<float>::Mode::LPF24);
+        filter.setCutoffFrequencyHz(filtFreq->getCurrentValue());
+        filter.setDrive(filtDrive->getCurrentValue());
+        filter.setResonance(jlimit(0.f, 1.f, filtRes->getCurrentValue()));
+
+        if (oversamplingIndex == 0)
+        {
+            filter.process(dsp::ProcessContextReplacing<float>(block));
+        }
+        else
+        {
+            auto& oversampler = *oversamplers[(size_t)oversamplingIndex - 1];
+            // the oversampler hands back all its channels, a mono voice only wants the first
+            auto upsampled = oversampler.processSamplesUp(block).getSubsetChannelBlock(0, (size_t)numVoiceChannels);
+            filter.process(dsp::ProcessContextReplacing<float>(upsampled));
+            oversampler.processSamplesDown(block);
+        }
+    }
+
+    /*
+        The filter in two halves so the lane engine can put every voice's channels through LadderLanes together:
+        beginFilter() upsamples if it needs to and fills in one lane per voice channel (returns how many, 0 when
+        the filter is off), endFilter() brings the filtered audio back down into voiceBuffer
+    */
+    int beginFilter(int numSamples, LadderLanes::Lane* lanes)
+    {
+        applyOversampling();
+
+        if (! isFiltering)
+            return 0;
+
+        auto block = getFilterBlock(numSamples);
+
+        if (oversamplingIndex > 0)
+        {
+            // the oversampler hands back all its channels, a mono voice only wants the first
+            block = oversamplers[(size_t)oversamplingIndex - 1]->processSamplesUp(block)
+                                                               .getSubsetChannelBlock(0, (size_t)numVoiceChannels);
+        }
+
+        for (int channel = 0; channel < numVoiceChannels; ++channel)
+        {
+            auto& lane = lanes[channel];
+            lane.state = &ladderStates[(size_t)channel];
+            lane.audio = block.getChannelPointer((size_t)channel);
+            lane.cutoff = controlBuffer.getReadPointer(cutoffChannel);
+            lane.cutoffShift = oversamplingIndex;
+            lane.numSamples = (int)block.getNumSamples();
+            lane.resonance = jlimit(0.f, 1.f, filtRes->getCurrentValue());
+            lane.drive = filtDrive->getCurrentValue();
+            lane.sampleRate = (float)(getSampleRate() * (double)(1 << oversamplingIndex));
+            lane.mode = ladderMode;
+        }
+
+        return numVoiceChannels;
+    }
+
+    /*
+        Switches to the factor setOversampling() asked for. Only ever called from the render, which holds the voice
+        lock, so it can't meet GaySynth::setOversamplingFilter() swapping the oversamplers out. A factor that isn't
+        built yet (before prepare) stays off until it is
+    */
+    void applyOversampling()
+    {
+        auto factorIndex = requestedOversampling;
+
+        if (factorIndex > 0 && oversamplers[(size_t)factorIndex - 1] == nullptr)
+            factorIndex = 0;
+
+        if (factorIndex != oversamplingIndex)
+        {
+            // the filter state was built up at the old rate, start it from rest rather than from a wrong one
+            oversamplingIndex = factorIndex;
+
+            for (auto& state : ladderStates)
+                state.reset();
+
+            referenceFilters[(size_t)oversamplingIndex].reset();
+
+            if (oversamplingIndex > 0)
+                oversamplers[(size_t)oversamplingIndex - 1]->reset();
+        }
+    }
+
+    void endFilter(int numSamples)
+    {
+        if (isFiltering && oversamplingIndex > 0)
+            oversamplers[(size_t)oversamplingIndex - 1]->processSamplesDown(getFilterBlock(numSamples));
+    }
+
+    dsp::AudioBlock<float> getFilterBlock(int numSamples)
+    {
+        return dsp::AudioBlock<float>(voiceBuffer).getSubsetChannelBlock(0, (size_t)numVoiceChannels)
+                                                  .getSubBlock(0, (size_t)numSamples);
+    }
+
+    void addToOutput(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+    {
+        for (int channel = 0; channel < outputBuffer.getNumChannels(); channel++)
+        {
+            // TO DO: Pan settings for osc?
+            auto* voiceOut = voiceBuffer.getReadPointer(channel % numVoiceChannels);
+            FloatVectorOperations::add(outputBuffer.getWritePointer(channel, startSample), voiceOut, numSamples);
+        }
+
+        // what's left of a stolen note
+        auto numTail = jmin(numSamples, stealTailLength - stealTailPosition);
+
+        if (numTail > 0)
+        {
+            for (int channel = 0; channel < outputBuffer.getNumChannels(); channel++)
+            {
+                auto* tail = stealTail.getReadPointer(channel % stealTail.getNumChannels(), stealTailPosition);
+                FloatVectorOperations::add(outputBuffer.getWritePointer(channel, startSample), tail, numTail);
+            }
+
+            stealTailPosition += numTail;
+        }
+    }
+
+    // how loud the note is for the allocator's quietest-first stealing, the amp env's level
+    float getLevel()
+    {
+        return env1.getCurrentValue();
+    }
+
+    /*
+        the original per sample loop (into voiceBuffer now, not the shared output), this is what reference quality renders.
+        Unison stacks render per sample in here too, stereo the same as renderVoice()
+    */
+    void renderReference(int numSamples, RenderScratch& scratch)
+    {
+        TableInterpolation::dispatch(osc1.getInterpolation(), [&](auto kernel)
+        {
+            renderReference<decltype(kernel)>(numSamples, scratch);
+        });
+    }
+
+    template <typename Kernel>
+    void renderReference(int numSamples, RenderScratch& scratch)
+    {
+        numVoiceChannels = (osc1.isStereo() || osc2.isStereo()) ? 2 : 1;
+        auto* voiceLeft = voiceBuffer.getWritePointer(0);
+        auto* voiceRight = voiceBuffer.getWritePointer(numVoiceChannels - 1);
+        auto* cutoff = controlBuffer.getWritePointer(cutoffChannel);
+        int sampleIndex = 0;
 
-        for (int sampleIndex = startSample; sampleIndex < numSamples; ++sampleIndex) // start from start sample incase it is not 0 (usually is)
+        for (; sampleIndex < numSamples; ++sampleIndex)
         {
             if (env1.isActive()) // env1 is the "amp" env, so it controls note off (maybe I should name it that?)
             {
                 incrementLFOs();
                 incrementEnvelopes();
                 incrementFilter();
+                cutoff[sampleIndex] = filtFreq->getCurrentValue();
 
-                auto sample = (osc1.getNextSample() + osc2.getNextSample()) * env1.getCurrentValue();
-                
-                for (int channel = 0; channel < outputBuffer.getNumChannels(); channel++)
-                {
-                    // TO DO: Pan settings for osc?
-                    blockWrite[channel][sampleIndex] += sample * 0.3f;
-                }
+                float left1, right1, left2, right2;
+                osc1.getNextSample<Kernel>(left1, right1, scratch.unison);
+                osc2.getNextSample<Kernel>(left2, right2, scratch.unison);
+
+                auto amp = env1.getCurrentValue();
+                voiceLeft[sampleIndex] = (left1 + left2) * amp * 0.3f;
+                voiceRight[sampleIndex] = (right1 + right2) * amp * 0.3f; // the same as left when it's mono
             }
             else
             {
-               // Not only does the voice release with this 'clearCurrentNote()' commented out
-               // It resolves a clicking noise I was dealing with
-               // How does this work?
-                
-               // clearCurrentNote();
+                // the note gets cleared once the filter has rung out, see isTailFinished()
                 break;
             }
         }
-        if (isFiltering)
+
+        for (int channel = 0; channel < numVoiceChannels; ++channel)
+            FloatVectorOperations::clear(voiceBuffer.getWritePointer(channel, sampleIndex), numSamples - sampleIndex);
+
+        holdCutoff(sampleIndex, numSamples);
+    }
+
+    // returns how many samples the amp env stayed active for, nothing past that gets rendered
+    int renderControls(int numSamples)
+    {
+        if (! controlTicks.isAudioRate())
+            return renderControlTicks(numSamples);
+
+        auto* lfoOut1 = controlBuffer.getWritePointer(lfo1Channel);
+        auto* lfoOut2 = controlBuffer.getWritePointer(lfo2Channel);
+        auto* lfoOut3 = controlBuffer.getWritePointer(lfo3Channel);
+        auto* envOut1 = controlBuffer.getWritePointer(env1Channel);
+        auto* envOut2 = controlBuffer.getWritePointer(env2Channel);
+        auto* envOut3 = controlBuffer.getWritePointer(env3Channel);
+
+        int numActive = 0;
+        for (; numActive < numSamples && env1.isActive(); ++numActive)
+        {
+            // lfo rate / depth read last sample's envelope values, so these two stay interleaved
+            incrementLFOs();
+            incrementEnvelopes();
+
+            lfoOut1[numActive] = lfo1->getCurrentSample();
+            lfoOut2[numActive] = lfo2->getCurrentSample();
+            lfoOut3[numActive] = lfo3->getCurrentSample();
+
+            envOut1[numActive] = env1.getCurrentValue();
+            envOut2[numActive] = env2.getCurrentValue();
+            envOut3[numActive] = env3.getCurrentValue();
+        }
+
+        // the filter reads cutoff per sample, drive and resonance only use the last value (the scratch keeps their smoothing in step)
+        auto* filterScratch = controlBuffer.getWritePointer(filterChannel);
+        filtFreq->getNextBlock(controlBuffer.getWritePointer(cutoffChannel), numActive);
+        filtDrive->getNextBlock(filterScratch, numActive);
+        filtRes->getNextBlock(filterScratch, numActive);
+
+        holdCutoff(numActive, numSamples);
+        return numActive;
+    }
+
+    /*
+        renderControls() at control rate: the lfo's and envelopes move on a whole tick at a time and write one value
+        per tick into tickBuffer. The amp env is the only modulator used directly at audio rate, so that one gets
+        spread back out into controlBuffer for renderVoice(). Works in whole ticks, so the amp env can run up to a
+        tick past where it went idle (it's 0 by then)
+    */
+    int renderControlTicks(int numSamples)
+    {
+        auto* lfoOut1 = tickBuffer.getWritePointer(lfo1Channel);
+        auto* lfoOut2 = tickBuffer.getWritePointer(lfo2Channel);
+        auto* lfoOut3 = tickBuffer.getWritePointer(lfo3Channel);
+        auto* envOut1 = tickBuffer.getWritePointer(env1Channel);
+        auto* envOut2 = tickBuffer.getWritePointer(env2Channel);
+        auto* envOut3 = tickBuffer.getWritePointer(env3Channel);
+
+        auto interval = controlTicks.interval;
+        int numTicks = 0, numActive = 0;
+
+        for (; numActive < numSamples && env1.isActive(); ++numTicks)
         {
-            auto block = dsp::AudioBlock<float>(outputBuffer);
-            auto blockToUse = block.getSubBlock((size_t)startSample, (size_t)numSamples);
-            auto contextToUse = dsp::ProcessContextReplacing<float>(blockToUse);
+            auto length = jmin(interval, numSamples - numActive);
 
-            filter.setCutoffFrequencyHz(filtFreq->getCurrentValue());
-            filter.setDrive(filtDrive->getCurrentValue());
-            /*
-                TO DO: fix GayParam so I can do things like init 'val' and other stuff
-            */
-            filter.setResonance(jlimit(0.f, 1.f, filtRes->getCurrentValue()));
-            filter.process(contextToUse);
+            advanceLFOs(length);
+            env1.advance(length);
+            env2.advance(length);
+            env3.advance(length);
+
+            lfoOut1[numTicks] = lfo1->getCurrentSample();
+            lfoOut2[numTicks] = lfo2->getCurrentSample();
+            lfoOut3[numTicks] = lfo3->getCurrentSample();
+
+            envOut1[numTicks] = env1.getCurrentValue();
+            envOut2[numTicks] = env2.getCurrentValue();
+            envOut3[numTicks] = env3.getCurrentValue();
+
+            numActive += length;
         }
-        
+
+        controlTicks.numTicks = numTicks;
+        controlTicks.numSamples = numActive;
+
+        ampInterpolator.process(envOut1, controlTicks, controlBuffer.getWritePointer(env1Channel), ControlTicks::linear);
+
+        auto* filterScratch = controlBuffer.getWritePointer(filterChannel);
+        filtFreq->getNextTicks(filterScratch, controlTicks, controlBuffer.getWritePointer(cutoffChannel));
+        filtDrive->getNextTicks(filterScratch, controlTicks);
+        filtRes->getNextTicks(filterScratch, controlTicks);
+
+        holdCutoff(numActive, numSamples);
+        return numActive;
     }
 
+    // the filter keeps ringing once the amp env is done, at whatever cutoff it had
+    void holdCutoff(int numActive, int numSamples)
+    {
+        FloatVectorOperations::fill(controlBuffer.getWritePointer(cutoffChannel, numActive), filtFreq->getCurrentValue(), numSamples - numActive);
+    }
+
+    void renderOscillators(int numSamples, RenderScratch& scratch)
+    {
+        osc1.renderNextBlock(controlBuffer.getWritePointer(osc1Channel), controlBuffer.getWritePointer(osc1RightChannel), numSamples, scratch.unison);
+        osc2.renderNextBlock(controlBuffer.getWritePointer(osc2Channel), controlBuffer.getWritePointer(osc2RightChannel), numSamples, scratch.unison);
+    }
+
+    // numActive samples of voice, silence after that up to numSamples. Stereo as soon as either oscillator is
+    void renderVoice(int numActive, int numSamples)
+    {
+        numVoiceChannels = (osc1.isStereo() || osc2.isStereo()) ? 2 : 1;
+
+        for (int channel = 0; channel < numVoiceChannels; ++channel)
+        {
+            auto* voiceOut = voiceBuffer.getWritePointer(channel);
+
+            FloatVectorOperations::add(voiceOut, getOscOutput(osc1, osc1Channel, channel), getOscOutput(osc2, osc2Channel, channel), numActive);
+            FloatVectorOperations::multiply(voiceOut, controlBuffer.getReadPointer(env1Channel), numActive);
+            FloatVectorOperations::multiply(voiceOut, 0.3f, numActive);
+
+            FloatVectorOperations::clear(voiceOut + numActive, numSamples - numActive);
+        }
+    }
+
+    // a mono oscillator goes to both sides of a stereo voice
+    const float* getOscOutput(GayOscillator& osc, int leftChannel, int side) const
+    {
+        auto rightChannel = leftChannel == osc1Channel ? osc1RightChannel : osc2RightChannel;
+        return controlBuffer.getReadPointer(side == 1 && osc.isStereo() ? rightChannel : leftChannel);
+    }
+
+    //==============================================================================
+    // lane engine (GaySynth::EngineMode::lanes) - the synth runs these around VoiceLanes instead of calling renderNextBlock
+
+    // controls and oscillator params for one chunk (no bigger than getMaxBlockSize()), returns how long the amp env lasted
+    int renderLaneControls(int numSamples, RenderScratch& scratch)
+    {
+        auto numActive = renderControls(numSamples);
+        osc1.renderParams(numActive);
+        osc2.renderParams(numActive);
+
+        // unison stacks and oscillators in the middle of a bank crossfade don't fit a lane, they render themselves here
+        renderLaneOsc(osc1, 0, osc1Channel, osc1RightChannel, numActive, scratch);
+        renderLaneOsc(osc2, 1, osc2Channel, osc2RightChannel, numActive, scratch);
+
+        return numActive;
+    }
+
+    bool usesLane(int oscNum) const
+    {
+        return onLane[oscNum == 1 ? 0 : 1];
+    }
+
+    VoiceLanes::Lane getLane(int oscNum, int numSamples)
+    {
+        auto& osc = oscNum == 1 ? osc1 : osc2;
+        auto channel = oscNum == 1 ? osc1Channel : osc2Channel;
+
+        return { &osc.getWaveVector(), osc.getWaveBlock(), osc.getPitchBlock(), controlBuffer.getWritePointer(channel), numSamples };
+    }
+
+    /*
+        Once the lanes have filled the oscillator blocks, numActive is what renderLaneControls returned for this chunk.
+        Mixes the voice and fills in its filter lanes (see beginFilter()), the synth runs those through LadderLanes
+        with everyone else's before renderLaneOutput()
+    */
+    int renderLaneMix(int numActive, int numSamples, LadderLanes::Lane* filterLanes)
+    {
+        osc1.applyGain(controlBuffer.getWritePointer(osc1Channel), controlBuffer.getWritePointer(osc1RightChannel), numActive);
+        osc2.applyGain(controlBuffer.getWritePointer(osc2Channel), controlBuffer.getWritePointer(osc2RightChannel), numActive);
+        renderVoice(numActive, numSamples);
+        return beginFilter(numSamples, filterLanes);
+    }
+
+    void renderLaneOutput(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+    {
+        endFilter(numSamples);
+        auto finished = isTailFinished(numSamples);
+        addToOutput(outputBuffer, startSample, numSamples);
+
+        if (finished)
+            finishNote();
+    }
+
+    int getMaxBlockSize() const
+    {
+        return controlBuffer.getNumSamples();
+    }
+
+    void setReferenceQuality(bool shouldUseReference)
+    {
+        referenceQuality = shouldUseReference;
+    }
+
+    // both oscillators read their tables with kernel from the next block on (GaySynth picks it per quality)
+    void setInterpolation(TableInterpolation::Kernel kernel)
+    {
+        osc1.setInterpolation(kernel);
+        osc2.setInterpolation(kernel);
+    }
+
+    TableInterpolation::Kernel getInterpolation() const
+    {
+        return osc1.getInterpolation();
+    }
 
     void incrementLFOs()
     {
@@ -194,6 +889,22 @@ public:
         lfo3->getNextSample();
     }
 
+    // incrementLFOs() a tick at a time
+    void advanceLFOs(int numSamples)
+    {
+        lfo1->setFrequency(lfoRate1->getNextValue(numSamples));
+        lfo1->setGain(lfoDepth1->getNextValue(numSamples));
+        lfo1->advance(numSamples);
+
+        lfo2->setFrequency(lfoRate2->getNextValue(numSamples));
+        lfo2->setGain(lfoDepth2->getNextValue(numSamples));
+        lfo2->advance(numSamples);
+
+        lfo3->setFrequency(lfoRate3->getNextValue(numSamples));
+        lfo3->setGain(lfoDepth3->getNextValue(numSamples));
+        lfo3->advance(numSamples);
+    }
+
     void incrementEnvelopes()
     {
         env1.getNextSample();
@@ -211,8 +922,7 @@ public:
     void update(AudioProcessorValueTreeState& apvts)
     {  
         //////////////////// VOICE ////////////////////
-        auto filterMode = apvts.getRawParameterValue("Filter Mode")->load();
-        updateFilterMode(filterMode);
+        updateSettings(apvts);
 
         // set value on filter params (these are GayParam(s) that exist in the voice class)
         filtFreq->setValue(apvts.getRawParameterValue("Filter Freq")->load());
@@ -227,28 +937,6 @@ public:
         filtRes->setLFOScale(apvts.getRawParameterValue("Res LFO Scale")->load());
         filtRes->setEnvScale(apvts.getRawParameterValue("Res Env Scale")->load());
 
-        // assign filter modulation sources (occurs in voice class not oscillator)
-        auto fLFO = apvts.getRawParameterValue("Filter LFO Source")->load();
-        auto fEnv = apvts.getRawParameterValue("Filter Env Source")->load();
-
-        auto dLFO = apvts.getRawParameterValue("Drive LFO Source")->load();
-        auto dEnv = apvts.getRawParameterValue("Drive Env Source")->load();
-
-        auto rLFO = apvts.getRawParameterValue("Res LFO Source")->load();
-        auto rEnv = apvts.getRawParameterValue("Res Env Source")->load();
-
-        assignFilterMods(fLFO, dLFO, rLFO, fEnv, dEnv, rEnv);
-
-        // assign LFO modulation sources (envelopes only)
-        auto lEnv1 = apvts.getRawParameterValue("LFO Rate Env Source 1")->load();
-        auto lEnv2 = apvts.getRawParameterValue("LFO Rate Env Source 2")->load();
-        auto lEnv3 = apvts.getRawParameterValue("LFO Rate Env Source 3")->load();
-
-        auto depthEnv1 = apvts.getRawParameterValue("LFO Depth Env Source 1")->load();
-        auto depthEnv2 = apvts.getRawParameterValue("LFO Depth Env Source 2")->load();
-        auto depthEnv3 = apvts.getRawParameterValue("LFO Depth Env Source 3")->load();
-        assignLFOMods(lEnv1, lEnv2, lEnv3, depthEnv1, depthEnv2, depthEnv3);
-
         // LFO Params (in voice class)
         auto aRate1 = apvts.getRawParameterValue("LFO Rate 1")->load();
         auto rateScale1 = apvts.getRawParameterValue("LFO Rate Env Scale 1")->load();
@@ -278,30 +966,10 @@ public:
         auto gDepth3 = apvts.getRawParameterValue("LFO Depth 3")->load();
         auto gainScale3 = apvts.getRawParameterValue("LFO Depth Env Scale 3")->load();
         lfoDepth3->setValue(gDepth3);
-        lfoDepth3->setEnvScale(gainScale1);
-
-        // Assign Env params (in voice class)
-        auto atk1 = apvts.getRawParameterValue("ATTACK 1")->load();
-        auto dec1 = apvts.getRawParameterValue("DECAY 1")->load();
-        auto sus1 = apvts.getRawParameterValue("SUSTAIN 1")->load();
-        auto rel1 = apvts.getRawParameterValue("RELEASE 1")->load();
-        envParam1 = GayADSR::Parameters(atk1, dec1, sus1, rel1);
-
-        auto atk2 = apvts.getRawParameterValue("ATTACK 2")->load();
-        auto dec2 = apvts.getRawParameterValue("DECAY 2")->load();
-        auto sus2 = apvts.getRawParameterValue("SUSTAIN 2")->load();
-        auto rel2 = apvts.getRawParameterValue("RELEASE 2")->load();
-        envParam2 = GayADSR::Parameters(atk2, dec2, sus2, rel2);
-
-        auto atk3 = apvts.getRawParameterValue("ATTACK 3")->load();
-        auto dec3 = apvts.getRawParameterValue("DECAY 3")->load();
-        auto sus3 = apvts.getRawParameterValue("SUSTAIN 3")->load();
-        auto rel3 = apvts.getRawParameterValue("RELEASE 3")->load();
-        envParam3 = GayADSR::Parameters(atk3, dec3, sus3, rel3);
+        lfoDepth3->setEnvScale(gainScale3);
 
-        env1.setParameters(envParam1);
-        env2.setParameters(envParam2);
-        env3.setParameters(envParam3);
+        updateEnvelopes(apvts);
+        updateModSources(apvts);
 
         //////////////// OSCILLATORS ///////////////
         
@@ -321,18 +989,6 @@ public:
         osc1.update(g1, gLFOScale1, gEnvScale1,
             w1, wLFOScale1, wEnvScale1, p1, pLFOScale1, pEnvScale1);
 
-        // oscillator 1 modulation sources
-        auto gLFO1 = apvts.getRawParameterValue("Gain 1 LFO Source")->load();
-        auto gEnv1 = apvts.getRawParameterValue("Gain 1 Env Source")->load();
-
-        auto wLFO1 = apvts.getRawParameterValue("Wave 1 LFO Source")->load();
-        auto wEnv1 = apvts.getRawParameterValue("Wave 1 Env Source")->load();
-
-        auto pLFO1 = apvts.getRawParameterValue("Pitch 1 LFO Source")->load();
-        auto pEnv1 = apvts.getRawParameterValue("Pitch 1 Env Source")->load();
-
-        assignOscMods(osc1, gLFO1, wLFO1, pLFO1, gEnv1, wEnv1, pEnv1);
-
         // oscillator 2 params
         auto g2 = apvts.getRawParameterValue("Gain 2")->load();
         auto gLFOScale2 = apvts.getRawParameterValue("Gain 2 LFO Scale")->load();
@@ -349,6 +1005,107 @@ public:
         osc2.update(g2, gLFOScale2, gEnvScale2,
             w2, wLFOScale2, wEnvScale2, p2, pLFOScale2, pEnvScale2);
 
+        updateUnison(apvts);
+    }
+
+    /*
+        What update() does with the parameters that have no ParamTarget, a group at a time. A change to one of them
+        only redoes its own group, the smoothed values are left alone. Polyphony belongs to the synth, not the voice,
+        see GaySynth::updateGroup
+    */
+    enum class ParamGroup
+    {
+        none,       // nothing on the voices reads it (oversampling filter, that's message thread)
+        settings,   // control rate, filter mode, oversampling factor
+        modSources,
+        envelopes,
+        unison,
+        polyphony
+    };
+
+    static constexpr int numParamGroups = 6;
+
+    static ParamGroup getParamGroup(const String& parameterID)
+    {
+        if (parameterID == "Polyphony")
+            return ParamGroup::polyphony;
+
+        if (parameterID.contains("Source"))
+            return ParamGroup::modSources;
+
+        if (parameterID.startsWith("Unison"))
+            return ParamGroup::unison;
+
+        if (parameterID.startsWith("ATTACK") || parameterID.startsWith("DECAY")
+            || parameterID.startsWith("SUSTAIN") || parameterID.startsWith("RELEASE"))
+            return ParamGroup::envelopes;
+
+        if (parameterID == "Control Rate" || parameterID == "Control Interp"
+            || parameterID == "Filter Mode" || parameterID == "Oversampling")
+            return ParamGroup::settings;
+
+        return ParamGroup::none;
+    }
+
+    void updateGroup(ParamGroup group, AudioProcessorValueTreeState& apvts)
+    {
+        switch (group)
+        {
+        case ParamGroup::settings:      updateSettings(apvts); break;
+        case ParamGroup::modSources:    updateModSources(apvts); break;
+        case ParamGroup::envelopes:     updateEnvelopes(apvts); break;
+        case ParamGroup::unison:        updateUnison(apvts); break;
+        case ParamGroup::none:
+        case ParamGroup::polyphony:     break;
+        }
+    }
+
+    void updateSettings(AudioProcessorValueTreeState& apvts)
+    {
+        setControlRate(ControlTicks::intervalForChoice((int)apvts.getRawParameterValue("Control Rate")->load()),
+                       apvts.getRawParameterValue("Control Interp")->load() > 0.5f ? ControlTicks::cubic : ControlTicks::linear);
+
+        auto filterMode = apvts.getRawParameterValue("Filter Mode")->load();
+        updateFilterMode(filterMode);
+        setOversampling((int)apvts.getRawParameterValue("Oversampling")->load());
+    }
+
+    void updateModSources(AudioProcessorValueTreeState& apvts)
+    {
+        // assign filter modulation sources (occurs in voice class not oscillator)
+        auto fLFO = apvts.getRawParameterValue("Filter LFO Source")->load();
+        auto fEnv = apvts.getRawParameterValue("Filter Env Source")->load();
+
+        auto dLFO = apvts.getRawParameterValue("Drive LFO Source")->load();
+        auto dEnv = apvts.getRawParameterValue("Drive Env Source")->load();
+
+        auto rLFO = apvts.getRawParameterValue("Res LFO Source")->load();
+        auto rEnv = apvts.getRawParameterValue("Res Env Source")->load();
+
+        assignFilterMods(fLFO, dLFO, rLFO, fEnv, dEnv, rEnv);
+
+        // assign LFO modulation sources (envelopes only)
+        auto lEnv1 = apvts.getRawParameterValue("LFO Rate Env Source 1")->load();
+        auto lEnv2 = apvts.getRawParameterValue("LFO Rate Env Source 2")->load();
+        auto lEnv3 = apvts.getRawParameterValue("LFO Rate Env Source 3")->load();
+
+        auto depthEnv1 = apvts.getRawParameterValue("LFO Depth Env Source 1")->load();
+        auto depthEnv2 = apvts.getRawParameterValue("LFO Depth Env Source 2")->load();
+        auto depthEnv3 = apvts.getRawParameterValue("LFO Depth Env Source 3")->load();
+        assignLFOMods(lEnv1, lEnv2, lEnv3, depthEnv1, depthEnv2, depthEnv3);
+
+        // oscillator 1 modulation sources
+        auto gLFO1 = apvts.getRawParameterValue("Gain 1 LFO Source")->load();
+        auto gEnv1 = apvts.getRawParameterValue("Gain 1 Env Source")->load();
+
+        auto wLFO1 = apvts.getRawParameterValue("Wave 1 LFO Source")->load();
+        auto wEnv1 = apvts.getRawParameterValue("Wave 1 Env Source")->load();
+
+        auto pLFO1 = apvts.getRawParameterValue("Pitch 1 LFO Source")->load();
+        auto pEnv1 = apvts.getRawParameterValue("Pitch 1 Env Source")->load();
+
+        assignOscMods(osc1, gLFO1, wLFO1, pLFO1, gEnv1, wEnv1, pEnv1);
+
         // oscillator 2 modulation sources
         auto gLFO2 = apvts.getRawParameterValue("Gain 2 LFO Source")->load();
         auto gEnv2 = apvts.getRawParameterValue("Gain 2 Env Source")->load();
@@ -362,6 +1119,115 @@ public:
         assignOscMods(osc2, gLFO2, wLFO2, pLFO2, gEnv2, wEnv2, pEnv2);
     }
 
+    void updateEnvelopes(AudioProcessorValueTreeState& apvts)
+    {
+        // Assign Env params (in voice class)
+        auto atk1 = apvts.getRawParameterValue("ATTACK 1")->load();
+        auto dec1 = apvts.getRawParameterValue("DECAY 1")->load();
+        auto sus1 = apvts.getRawParameterValue("SUSTAIN 1")->load();
+        auto rel1 = apvts.getRawParameterValue("RELEASE 1")->load();
+        envParam1 = GayADSR::Parameters(atk1, dec1, sus1, rel1);
+
+        auto atk2 = apvts.getRawParameterValue("ATTACK 2")->load();
+        auto dec2 = apvts.getRawParameterValue("DECAY 2")->load();
+        auto sus2 = apvts.getRawParameterValue("SUSTAIN 2")->load();
+        auto rel2 = apvts.getRawParameterValue("RELEASE 2")->load();
+        envParam2 = GayADSR::Parameters(atk2, dec2, sus2, rel2);
+
+        auto atk3 = apvts.getRawParameterValue("ATTACK 3")->load();
+        auto dec3 = apvts.getRawParameterValue("DECAY 3")->load();
+        auto sus3 = apvts.getRawParameterValue("SUSTAIN 3")->load();
+        auto rel3 = apvts.getRawParameterValue("RELEASE 3")->load();
+        envParam3 = GayADSR::Parameters(atk3, dec3, sus3, rel3);
+
+        env1.setParameters(envParam1);
+        env2.setParameters(envParam2);
+        env3.setParameters(envParam3);
+    }
+
+    void updateUnison(AudioProcessorValueTreeState& apvts)
+    {
+        osc1.updateUnison((int)apvts.getRawParameterValue("Unison Voices 1")->load(),
+                          apvts.getRawParameterValue("Unison Detune 1")->load(),
+                          apvts.getRawParameterValue("Unison Spread 1")->load(),
+                          apvts.getRawParameterValue("Unison Blend 1")->load(),
+                          apvts.getRawParameterValue("Unison Phase 1")->load());
+
+
+        osc2.updateUnison((int)apvts.getRawParameterValue("Unison Voices 2")->load(),
+                          apvts.getRawParameterValue("Unison Detune 2")->load(),
+                          apvts.getRawParameterValue("Unison Spread 2")->load(),
+                          apvts.getRawParameterValue("Unison Blend 2")->load(),
+                          apvts.getRawParameterValue("Unison Phase 2")->load());
+    }
+
+    /*
+        Parameters that only feed one GayParam can change on their own, without update() going through everything.
+        The value goes to the GayParam's smoother, so only that one ramps. Anything else (mod sources, envelope times,
+        modes, unison, polyphony...) has no target and goes through its getParamGroup() instead
+    */
+    enum class ParamField
+    {
+        value,
+        offset,     // pitch knobs are an offset, not the smoothed value
+        lfoScale,
+        envScale
+    };
+
+    struct ParamTarget
+    {
+        int param = -1;     // which GayParam, see getTargetParam()
+        ParamField field = ParamField::value;
+
+        bool isValid() const { return param >= 0; }
+    };
+
+    static ParamTarget getParamTarget(const String& parameterID)
+    {
+        struct Entry { const char* id; int param; ParamField field; };
+
+        static const Entry entries[] =
+        {
+            { "Gain 1", 0, ParamField::value },             { "Gain 1 LFO Scale", 0, ParamField::lfoScale },    { "Gain 1 Env Scale", 0, ParamField::envScale },
+            { "Pitch 1", 1, ParamField::offset },           { "Pitch 1 LFO Scale", 1, ParamField::lfoScale },   { "Pitch 1 Env Scale", 1, ParamField::envScale },
+            { "Wave 1 Position", 2, ParamField::value },    { "Wave 1 LFO Scale", 2, ParamField::lfoScale },    { "Wave 1 Env Scale", 2, ParamField::envScale },
+            { "Gain 2", 3, ParamField::value },             { "Gain 2 LFO Scale", 3, ParamField::lfoScale },    { "Gain 2 Env Scale", 3, ParamField::envScale },
+            { "Pitch 2", 4, ParamField::offset },           { "Pitch 2 LFO Scale", 4, ParamField::lfoScale },   { "Pitch 2 Env Scale", 4, ParamField::envScale },
+            { "Wave 2 Position", 5, ParamField::value },    { "Wave 2 LFO Scale", 5, ParamField::lfoScale },    { "Wave 2 Env Scale", 5, ParamField::envScale },
+            { "Filter Freq", 6, ParamField::value },        { "Filter LFO Scale", 6, ParamField::lfoScale },    { "Filter Env Scale", 6, ParamField::envScale },
+            { "Filter Res", 7, ParamField::value },         { "Res LFO Scale", 7, ParamField::lfoScale },       { "Res Env Scale", 7, ParamField::envScale },
+            { "Filter Drive", 8, ParamField::value },       { "Drive LFO Scale", 8, ParamField::lfoScale },     { "Drive Env Scale", 8, ParamField::envScale },
+            { "LFO Rate 1", 9, ParamField::value },         { "LFO Rate Env Scale 1", 9, ParamField::envScale },
+            { "LFO Depth 1", 10, ParamField::value },       { "LFO Depth Env Scale 1", 10, ParamField::envScale },
+            { "LFO Rate 2", 11, ParamField::value },        { "LFO Rate Env Scale 2", 11, ParamField::envScale },
+            { "LFO Depth 2", 12, ParamField::value },       { "LFO Depth Env Scale 2", 12, ParamField::envScale },
+            { "LFO Rate 3", 13, ParamField::value },        { "LFO Rate Env Scale 3", 13, ParamField::envScale },
+            { "LFO Depth 3", 14, ParamField::value },       { "LFO Depth Env Scale 3", 14, ParamField::envScale },
+        };
+
+        for (auto& entry : entries)
+            if (parameterID == entry.id)
+                return { entry.param, entry.field };
+
+        return {};
+    }
+
+    // same as what update() does with that one parameter
+    void setParameter(ParamTarget target, float value)
+    {
+        auto* param = getTargetParam(target.param);
+        if (param == nullptr)
+            return;
+
+        switch (target.field)
+        {
+        case ParamField::value:     param->setValue(value); break;
+        case ParamField::offset:    param->setOffset(value); break;
+        case ParamField::lfoScale:  param->setLFOScale(value); break;
+        case ParamField::envScale:  param->setEnvScale(value); break;
+        }
+    }
+
     void updateFilterMode(int mode)
     {
         switch (mode)
@@ -369,14 +1235,14 @@ public:
         case 0:
             {
                 isFiltering = true;
-                filter.setMode(juce::dsp::LadderFilter<float>::Mode::HPF24);
+                ladderMode = LadderLanes::Mode::HPF24;
             }
             break;
 
         case 1:
             {
                 isFiltering = true;
-                filter.setMode(dsp::LadderFilter<float>::Mode::LPF24);
+                ladderMode = LadderLanes::Mode::LPF24;
             }
             break;
 
@@ -398,29 +1264,17 @@ public:
 
     }
 
-    // rethinking this oscNum business and the waveMenu overall
-    void loadTables(StringRef tableFilePath, int oscNum)
+    // new voices start from whatever the first voice is playing rather than the sine. Shares the banks, nothing's copied
+    void copyTablesFrom(GayVoice& other)
     {
-        if (oscNum == 1)
-        {
-            osc1.loadTables(tableFilePath);
-        }
-        else
-        {
-            osc2.loadTables(tableFilePath);
-        }
+        osc1.getWaveVector().copyTablesFrom(other.getTable(1));
+        osc2.getWaveVector().copyTablesFrom(other.getTable(2));
     }
 
-    void loadTableFromBuffer(AudioBuffer<float>& waveBuffer, int oscNum)
+    // polyphony dropped below this voice, fade out whatever it was playing (it frees itself after). Runs on the audio thread
+    void park()
     {
-        if (oscNum == 1)
-        {
-            osc1.loadTableFromBuffer(waveBuffer);
-        }
-        else
-        {
-            osc2.loadTableFromBuffer(waveBuffer);
-        }
+        noteStopped(false);
     }
 
    // void incrementFilter()
@@ -572,10 +1426,68 @@ public:
     }
 
 private:
-   dsp::LadderFilter<float> filter;
+   enum ControlChannel
+   {
+       lfo1Channel, lfo2Channel, lfo3Channel,
+       env1Channel, env2Channel, env3Channel,
+       filterChannel, cutoffChannel,
+       osc1Channel, osc2Channel,
+       osc1RightChannel, osc2RightChannel, // only used by oscillators with unison spread
+       numControlChannels,
+       numModChannels = env3Channel + 1 // the lfo / envelope channels, all tickBuffer has
+   };
+
+   static constexpr int numOversamplingFactors = 4; // off, 2x, 4x, 8x
+
+   std::array<LadderLanes::State, 2> ladderStates;
+   std::array<dsp::LadderFilter<float>, numOversamplingFactors> referenceFilters; // [0] runs at the base rate
+   LadderLanes::Mode ladderMode = LadderLanes::Mode::LPF24;
+   Oversamplers oversamplers;
+   int oversamplingIndex = 0;        // what the render is using
+   int requestedOversampling = 0;    // what update() last asked for, see applyOversampling()
+   RenderScratch* audioThreadScratch = nullptr;
+   bool linearPhaseOversampling = false;
+   int maxBlockSize = 0;
    bool isFiltering = true;
+   bool referenceQuality = false;
+
+   static constexpr float silenceThreshold = 1.0e-5f; // -100dB, below this the tail counts as finished
+   static constexpr float cutOffFadeSeconds = 0.005f;
+   static constexpr float stealFadeSeconds = 0.002f;
+   int tailSamples = 0; // how long the amp env has been done for
+   bool hasNote = false; // from noteStarted() until finishNote(), a note that comes in between means this voice was stolen
+
+   AudioBuffer<float> stealTail; // the end of a stolen note, played out under the next one
+   int stealTailLength = 0, stealTailPosition = 0;
+
+   AudioBuffer<float> controlBuffer; // one block of every lfo / envelope, plus the oscillator outputs
+   AudioBuffer<float> tickBuffer;    // lfo / envelope values, one per tick, at control rate
+   ControlTicks controlTicks;
+   ControlInterpolator ampInterpolator;
+   AudioBuffer<float> voiceBuffer;   // this voice alone, filtered before it's added to the output
+   int numVoiceChannels = 1;         // how many of voiceBuffer's channels the current chunk uses (2 with unison spread)
 
    GayOscillator osc1, osc2;
+   bool onLane[2] { true, true }; // whether each oscillator's wavetable part went to VoiceLanes this chunk
+
+   // one oscillator's side of renderLaneControls(), after renderParams()
+   void renderLaneOsc(GayOscillator& osc, int index, int leftChannel, int rightChannel, int numSamples, RenderScratch& scratch)
+   {
+       auto& vector = osc.getWaveVector();
+       auto wasOnLane = onLane[index];
+       onLane[index] = ! osc.isUnison() && ! vector.isFading();
+
+       if (wasOnLane != onLane[index])
+       {
+           if (onLane[index])
+               vector.syncLanesFromWave();
+           else
+               vector.syncWaveFromLanes();
+       }
+
+       if (! onLane[index])
+           osc.renderWave(controlBuffer.getWritePointer(leftChannel), controlBuffer.getWritePointer(rightChannel), numSamples, scratch.unison);
+   }
     
    std::unique_ptr<WaveTable> lfo1, lfo2, lfo3;
    
@@ -586,6 +1498,29 @@ private:
    std::unique_ptr<GayParam> lfoRate1, lfoRate2, lfoRate3;
    std::unique_ptr<GayParam> lfoDepth1, lfoDepth2, lfoDepth3;
 
+   GayParam* getTargetParam(int param)
+   {
+       switch (param)
+       {
+       case 0:  return osc1.getParam(GayParam::gain);
+       case 1:  return osc1.getParam(GayParam::pitch);
+       case 2:  return osc1.getParam(GayParam::wave);
+       case 3:  return osc2.getParam(GayParam::gain);
+       case 4:  return osc2.getParam(GayParam::pitch);
+       case 5:  return osc2.getParam(GayParam::wave);
+       case 6:  return filtFreq.get();
+       case 7:  return filtRes.get();
+       case 8:  return filtDrive.get();
+       case 9:  return lfoRate1.get();
+       case 10: return lfoDepth1.get();
+       case 11: return lfoRate2.get();
+       case 12: return lfoDepth2.get();
+       case 13: return lfoRate3.get();
+       case 14: return lfoDepth3.get();
+       default: return nullptr;
+       }
+   }
+
    double glideTime = 0.01;
 
    float pitch = 0.f;
@@ -0,0 +1,209 @@
+/*
+  ==============================================================================
+
+    LadderLanes.h
+    Created: 17 Oct 2026 9:03:22pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/*
+    The voice filter: the same moog style ladder as dsp::LadderFilter (same stages, modes, drive and resonance
+    maths) run over several voices at once, one voice channel per simd lane. 8 lanes on AVX builds, 4 otherwise.
+
+    Differences from dsp::LadderFilter:
+        - cutoff is read per sample from a buffer (the voice's filter freq param block), so filter envelopes and
+          lfo's move it smoothly instead of once a block. dsp::LadderFilter took one value per block and ramped to it
+        - the exp for the cutoff and the tanh saturation are rational approximations instead of std::exp / a table,
+          both are plain arithmetic so the whole sample step vectorizes
+        - resonance and drive are per block, resonance ramps from last block's value
+    The filter state lives with the voice (State), this only has scratch, so any set of voices can be batched
+    together from block to block. A lane on its own runs through a 1 wide version of the same code.
+*/
+class LadderLanes
+{
+public:
+   #if defined(__AVX__)
+    static constexpr int laneWidth = 8;
+   #else
+    static constexpr int laneWidth = 4;
+   #endif
+
+    enum class Mode
+    {
+        LPF12, HPF12, BPF12,
+        LPF24, HPF24, BPF24
+    };
+
+    // one channel of one voice
+    struct State
+    {
+        float s[5] {};
+        float resonance = -1.f; // last block's, below 0 means there wasn't one
+
+        void reset()
+        {
+            for (auto& stage : s)
+                stage = 0.f;
+
+            resonance = -1.f;
+        }
+    };
+
+    struct Lane
+    {
+        State* state = nullptr;
+        float* audio = nullptr;         // filtered in place
+        const float* cutoff = nullptr;  // Hz, one per sample at the base rate
+        int cutoffShift = 0;            // oversampled by 2^cutoffShift, so audio sample i reads cutoff[i >> cutoffShift]
+        int numSamples = 0;
+        float resonance = 0.f;          // 0 - 1
+        float drive = 1.f;              // 1 - 10
+        float sampleRate = 44100.f;     // the rate the audio runs at, oversampled or not
+        Mode mode = Mode::LPF24;
+    };
+
+    // lanes that sit next to each other and have the same length go through together
+    void process(const Lane* lanes, int numLanes)
+    {
+        for (int first = 0; first < numLanes;)
+        {
+            auto count = 1;
+            while (first + count < numLanes && count < laneWidth && lanes[first + count].numSamples == lanes[first].numSamples)
+                ++count;
+
+            if (count == 1)
+                processGroup<1>(lanes + first, 1);
+            else
+                processGroup<laneWidth>(lanes + first, count);
+
+            first += count;
+        }
+    }
+
+private:
+    alignas(64) float s0[laneWidth], s1[laneWidth], s2[laneWidth], s3[laneWidth], s4[laneWidth];
+    alignas(64) float A0[laneWidth], A1[laneWidth], A2[laneWidth], A3[laneWidth], A4[laneWidth];
+    alignas(64) float comp[laneWidth], gain[laneWidth], drive[laneWidth], gain2[laneWidth], drive2[laneWidth];
+    alignas(64) float resonance[laneWidth], resonanceStep[laneWidth], cutoffScale[laneWidth];
+    alignas(64) float input[laneWidth], cutoff[laneWidth], output[laneWidth];
+
+    // jlimit without the compares, compares stop the lane loops vectorizing unless the build turns off fp traps
+    static float clampNoBranch(float x, float low, float high) noexcept
+    {
+        return 0.5f * (std::abs(x - low) + low + high - std::abs(x - high));
+    }
+
+    // tanh, good to about 2% and exactly +-1 past +-3
+    static float fastTanh(float x) noexcept
+    {
+        x = clampNoBranch(x, -3.f, 3.f);
+        auto x2 = x * x;
+        return x * (27.f + x2) / (27.f + 9.f * x2);
+    }
+
+    // exp(-w) for w from 0 to pi (dc up to nyquist), 3,3 pade
+    static float fastExpNegative(float w) noexcept
+    {
+        auto w2 = w * w;
+        auto w3 = w2 * w;
+        return (120.f - 60.f * w + 12.f * w2 - w3) / (120.f + 60.f * w + 12.f * w2 + w3);
+    }
+
+    // the output mix of the five stages and how much of the input the resonance takes back out, same as dsp::LadderFilter
+    static void getModeCoefficients(Mode mode, float* A, float& compensation)
+    {
+        const float coefficients[6][5] = { { 0.f, 0.f, 1.f, 0.f, 0.f },     // LPF12
+                                           { 1.f, -2.f, 1.f, 0.f, 0.f },    // HPF12
+                                           { 0.f, 0.f, -1.f, 1.f, 0.f },    // BPF12
+                                           { 0.f, 0.f, 0.f, 0.f, 1.f },     // LPF24
+                                           { 1.f, -4.f, 6.f, -4.f, 1.f },   // HPF24
+                                           { 0.f, 0.f, 1.f, -2.f, 1.f } };  // BPF24
+
+        auto index = (int)mode;
+        for (int i = 0; i < 5; ++i)
+            A[i] = coefficients[index][i] * 1.2f;
+
+        compensation = (mode == Mode::HPF12 || mode == Mode::HPF24) ? 0.f : 0.5f;
+    }
+
+    template <int width>
+    void processGroup(const Lane* lanes, int numUsed)
+    {
+        auto numSamples = lanes[0].numSamples;
+
+        // unused lanes run lane 0's settings on their own copy of its state and never get written out
+        for (int l = 0; l < width; ++l)
+        {
+            auto& lane = lanes[l < numUsed ? l : 0];
+            auto& state = *lane.state;
+
+            s0[l] = state.s[0]; s1[l] = state.s[1]; s2[l] = state.s[2]; s3[l] = state.s[3]; s4[l] = state.s[4];
+
+            float A[5];
+            getModeCoefficients(lane.mode, A, comp[l]);
+            A0[l] = A[0]; A1[l] = A[1]; A2[l] = A[2]; A3[l] = A[3]; A4[l] = A[4];
+
+            drive[l] = lane.drive;
+            gain[l] = std::pow(drive[l], -2.642f) * 0.6103f + 0.3903f;
+            drive2[l] = drive[l] * 0.04f + 0.96f;
+            gain2[l] = std::pow(drive2[l], -2.642f) * 0.6103f + 0.3903f;
+
+            auto target = jmap(jlimit(0.f, 1.f, lane.resonance), 0.1f, 1.f);
+            resonance[l] = state.resonance < 0.f ? target : state.resonance;
+            resonanceStep[l] = numSamples > 0 ? (target - resonance[l]) / (float)numSamples : 0.f;
+
+            cutoffScale[l] = MathConstants<float>::twoPi / lane.sampleRate;
+        }
+
+        const auto maxW = MathConstants<float>::pi * 0.99f;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            for (int l = 0; l < width; ++l)
+            {
+                auto& lane = lanes[l < numUsed ? l : 0];
+                input[l] = lane.audio[i];
+                cutoff[l] = lane.cutoff[i >> lane.cutoffShift];
+            }
+
+            for (int l = 0; l < width; ++l)
+            {
+                auto w = clampNoBranch(cutoff[l] * cutoffScale[l], 0.f, maxW);
+
+                auto a1 = fastExpNegative(w);
+                auto g = 1.f - a1;
+                auto b0 = g * 0.76923076923f;
+                auto b1 = g * 0.23076923076f;
+
+                resonance[l] += resonanceStep[l];
+
+                auto dx = gain[l] * fastTanh(drive[l] * input[l]);
+                auto a = dx + resonance[l] * -4.f * (gain2[l] * fastTanh(drive2[l] * s4[l]) - dx * comp[l]);
+
+                auto b = b1 * s0[l] + a1 * s1[l] + b0 * a;
+                auto c = b1 * s1[l] + a1 * s2[l] + b0 * b;
+                auto d = b1 * s2[l] + a1 * s3[l] + b0 * c;
+                auto e = b1 * s3[l] + a1 * s4[l] + b0 * d;
+
+                s0[l] = a; s1[l] = b; s2[l] = c; s3[l] = d; s4[l] = e;
+
+                output[l] = a * A0[l] + b * A1[l] + c * A2[l] + d * A3[l] + e * A4[l];
+            }
+
+            for (int l = 0; l < numUsed; ++l)
+                lanes[l].audio[i] = output[l];
+        }
+
+        for (int l = 0; l < numUsed; ++l)
+        {
+            auto& state = *lanes[l].state;
+            state.s[0] = s0[l]; state.s[1] = s1[l]; state.s[2] = s2[l]; state.s[3] = s3[l]; state.s[4] = s4[l];
+            state.resonance = resonance[l];
+        }
+    }
+};
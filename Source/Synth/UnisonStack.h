@@ -0,0 +1,283 @@
+/*
+  ==============================================================================
+
+    UnisonStack.h
+    Created: 17 Oct 2026 8:14:51pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../WaveTable/WaveTableVector.h"
+
+/*
+    Unison / supersaw stack for one oscillator: up to maxVoices copies of the same wave, each detuned and panned
+    a little differently.
+
+    Every copy reads the same two tables at the same wave position, so the wave position smoothing and the table
+    lookup (WaveTableVector::getNextFrame) happen once per sample for the whole stack. Only the phase is per copy.
+    The mip level comes from the sharpest copy's pitch so none of them alias, the others lose a few cents' worth of top end.
+    The copies run as lanes: every step is a plain loop over the lanes so the compiler turns it into vector ops
+    (same idea as VoiceLanes), and the mix down to left / right is a fixed pairwise sum so it vectorizes too and
+    doesn't change with the build.
+
+    Detune, blend and pan work out one ratio and two gains per copy, and only when a setting changes (update()
+    runs once a block at most), nothing in the sample loop looks at them.
+        detune  - cents between the lowest and highest copy
+        spread  - 0 is mono (only the left output gets written), 1 pans the outer copies hard left / right
+        blend   - level of the side copies against the middle one(s), 1 is all the same
+        phase   - 0 restarts every copy at the start of the table on note on, 1 starts each one somewhere random
+*/
+class UnisonStack
+{
+public:
+    static constexpr int maxVoices = 16;
+
+    void prepare(double sampleRate)
+    {
+        phaseScale = (float)((double)tableSize / sampleRate);
+    }
+
+    void setParameters(int newNumVoices, float newDetuneCents, float newSpread, float newBlend, float newPhaseRandom)
+    {
+        newNumVoices = jlimit(1, maxVoices, newNumVoices);
+
+        phaseRandom = newPhaseRandom;
+
+        if (newNumVoices == numVoices && newDetuneCents == detuneCents && newSpread == spread && newBlend == blend)
+            return;
+
+        numVoices = newNumVoices;
+        detuneCents = newDetuneCents;
+        spread = newSpread;
+        blend = newBlend;
+        updateLayout();
+    }
+
+    int getNumVoices() const
+    {
+        return numVoices;
+    }
+
+    bool isStereo() const
+    {
+        return numVoices > 1 && spread > 0.f;
+    }
+
+    void noteOn()
+    {
+        for (int v = 0; v < maxVoices; ++v)
+            phase[v] = phaseRandom * random.nextFloat() * (float)tableSize;
+    }
+
+    /*
+        Per sample working space, nothing carries over between samples. It's 64 byte aligned and the same for every
+        stack, so whoever renders hands one in rather than each stack carrying its own (GayVoice::RenderScratch)
+    */
+    struct Scratch
+    {
+        alignas(64) float frac[maxVoices], sample[maxVoices], mixLeft[maxVoices], mixRight[maxVoices];
+        alignas(64) float lowerSample[maxVoices], upperSample[maxVoices];
+        alignas(64) int index0[maxVoices], index1[maxVoices];
+    };
+
+    // wave / pitch are the oscillator's param blocks, right can be null when the stack isn't stereo. Reads with the vector's kernel
+    void render(WaveTableVector& vector, const float* wave, const float* pitch, float* left, float* right, int numSamples,
+                Scratch& scratch)
+    {
+        TableInterpolation::dispatch(vector.getInterpolation(), [&](auto kernel)
+        {
+            renderWith<decltype(kernel)>(vector, wave, pitch, left, right, numSamples, scratch);
+        });
+    }
+
+    // the same with the kernel already picked, the voice's reference loop goes through this a sample at a time
+    template <typename Kernel>
+    void render(WaveTableVector& vector, const float* wave, const float* pitch, float* left, float* right, int numSamples,
+                Scratch& scratch)
+    {
+        renderWith<Kernel>(vector, wave, pitch, left, right, numSamples, scratch);
+    }
+
+private:
+    static constexpr int tableSize = 2048;
+
+    int numVoices = 1, numLanes = 1;
+    float detuneCents = 0.f, spread = 0.f, blend = 1.f, phaseRandom = 1.f;
+    float phaseScale = 0.f;
+    float maxRatio = 1.f;               // the sharpest copy
+    float mipDelta = -1.f;              // the level is only worked out again when the pitch moves
+    int mipLevel = 0;
+    Random random { 0x554e49 }; // fixed seed, renders of the same notes come out the same
+
+    // the stack lives in the voice, so nothing in it is aligned past 16 (see GaySynth's voice arena)
+    alignas(16) float phase[maxVoices] {};
+    alignas(16) float ratio[maxVoices] {};
+    alignas(16) float gainLeft[maxVoices] {};
+    alignas(16) float gainRight[maxVoices] {};
+
+    template <typename Kernel>
+    void renderWith(WaveTableVector& vector, const float* wave, const float* pitch, float* left, float* right, int numSamples,
+                    Scratch& scratch)
+    {
+        auto width = numLanes;
+        auto* index0 = scratch.index0;
+        auto* index1 = scratch.index1;
+        auto* frac = scratch.frac;
+        auto* sample = scratch.sample;
+        auto* mixLeft = scratch.mixLeft;
+        auto* mixRight = scratch.mixRight;
+        auto* lowerSample = scratch.lowerSample;
+        auto* upperSample = scratch.upperSample;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto delta = pitch[i] * phaseScale;
+
+            if (delta != mipDelta)
+            {
+                float fade;
+                mipDelta = delta;
+                mipLevel = WaveTable::getMipLevel(delta * maxRatio, fade);
+            }
+
+            WaveTable::Mip lower, upper;
+            float interp = 0.f;
+            vector.getNextFrame(wave[i], mipLevel, lower, upper, interp);
+
+            // both tables are at the same level, so the same size
+            for (int v = 0; v < width; ++v)
+            {
+                auto position = phase[v] * lower.scale;
+                index0[v] = (int)position;
+                frac[v] = position - (float)index0[v];
+                index0[v] &= lower.mask;
+                index1[v] = (index0[v] + 1) & lower.mask;
+            }
+
+            // both tables are shared by every lane, so these are gathers from one base
+            readLanes<Kernel>(scratch, lower, lowerSample, width);
+            readLanes<Kernel>(scratch, upper, upperSample, width);
+
+            for (int v = 0; v < width; ++v)
+                sample[v] = lowerSample[v] + interp * (upperSample[v] - lowerSample[v]);
+
+            // for a few ms after a bank swap, the bank it's leaving at the same level and phase
+            WaveTable::Mip fadeLower, fadeUpper;
+            float fadeInterp = 0.f;
+            auto fade = vector.getFadeFrame(mipLevel, fadeLower, fadeUpper, fadeInterp);
+
+            if (fade > 0.f)
+            {
+                readLanes<Kernel>(scratch, fadeLower, lowerSample, width);
+                readLanes<Kernel>(scratch, fadeUpper, upperSample, width);
+
+                for (int v = 0; v < width; ++v)
+                {
+                    auto fadeSample = lowerSample[v] + fadeInterp * (upperSample[v] - lowerSample[v]);
+                    sample[v] += fade * (fadeSample - sample[v]);
+                }
+            }
+
+            for (int v = 0; v < width; ++v)
+            {
+                mixLeft[v] = sample[v] * gainLeft[v];
+                mixRight[v] = sample[v] * gainRight[v];
+
+                phase[v] += delta * ratio[v];
+                phase[v] = phase[v] >= (float)tableSize ? phase[v] - (float)tableSize : phase[v];
+            }
+
+            left[i] = sumLanes(mixLeft, width);
+
+            if (right != nullptr)
+                right[i] = sumLanes(mixRight, width);
+        }
+    }
+
+    // every lane's sample from one table at index0 / frac. Linear is the lerp it always was, the others add up a tap at a time
+    template <typename Kernel>
+    static void readLanes(const Scratch& scratch, const WaveTable::Mip& mip, float* dest, int width)
+    {
+        auto* index0 = scratch.index0;
+        auto* index1 = scratch.index1;
+        auto* frac = scratch.frac;
+
+        if constexpr (std::is_same_v<Kernel, TableInterpolation::Linear>)
+        {
+            for (int v = 0; v < width; ++v)
+                dest[v] = mip.data[index0[v]] + frac[v] * (mip.data[index1[v]] - mip.data[index0[v]]);
+        }
+        else
+        {
+            for (int v = 0; v < width; ++v)
+                dest[v] = 0.f;
+
+            addTaps<Kernel>(scratch, mip, dest, width, std::make_integer_sequence<int, Kernel::numTaps>());
+        }
+    }
+
+    template <typename Kernel, int... taps>
+    static void addTaps(const Scratch& scratch, const WaveTable::Mip& mip, float* dest, int width, std::integer_sequence<int, taps...>)
+    {
+        (addTap<Kernel, taps>(scratch, mip, dest, width), ...);
+    }
+
+    template <typename Kernel, int tap>
+    static void addTap(const Scratch& scratch, const WaveTable::Mip& mip, float* dest, int width)
+    {
+        for (int v = 0; v < width; ++v)
+            dest[v] += Kernel::template weight<tap>(scratch.frac[v]) * mip.data[(scratch.index0[v] + Kernel::firstTap + tap) & mip.mask];
+    }
+
+    // pairwise, width is a power of two. Sums the same way every time, so the result only depends on the input
+    static float sumLanes(float* lanes, int width)
+    {
+        for (int half = width / 2; half > 0; half /= 2)
+            for (int v = 0; v < half; ++v)
+                lanes[v] += lanes[v + half];
+
+        return lanes[0];
+    }
+
+    void updateLayout()
+    {
+        numLanes = (int)nextPowerOfTwo(numVoices);
+
+        // copies sit evenly from -1 to 1, the middle one (or two) are the ones blend leaves alone
+        float weights[maxVoices] {};
+        float power = 0.f;
+
+        for (int v = 0; v < numVoices; ++v)
+        {
+            auto position = numVoices > 1 ? 2.f * (float)v / (float)(numVoices - 1) - 1.f : 0.f;
+            auto isMiddle = std::abs(position) <= 1.f / (float)jmax(1, numVoices - 1) + 1.0e-4f;
+
+            weights[v] = isMiddle ? 1.f : blend;
+            power += weights[v] * weights[v];
+
+            ratio[v] = std::pow(2.f, position * 0.5f * detuneCents / 1200.f);
+
+            // equal power pan, scaled so a copy in the middle comes out at the same level as a mono one
+            auto angle = (jlimit(-1.f, 1.f, position * spread) + 1.f) * MathConstants<float>::pi * 0.25f;
+            gainLeft[v] = isStereo() ? std::cos(angle) * MathConstants<float>::sqrt2 : 1.f;
+            gainRight[v] = isStereo() ? std::sin(angle) * MathConstants<float>::sqrt2 : 0.f;
+        }
+
+        // more copies shouldn't mean louder (they're uncorrelated once they drift apart)
+        auto normalise = power > 0.f ? 1.f / std::sqrt(power) : 1.f;
+
+        for (int v = 0; v < maxVoices; ++v)
+        {
+            auto weight = v < numVoices ? weights[v] * normalise : 0.f;
+            gainLeft[v] = v < numVoices ? gainLeft[v] * weight : 0.f;
+            gainRight[v] = v < numVoices ? gainRight[v] * weight : 0.f;
+            ratio[v] = v < numVoices ? ratio[v] : 1.f;
+        }
+
+        maxRatio = *std::max_element(std::begin(ratio), std::end(ratio));
+        mipDelta = -1.f;
+    }
+};
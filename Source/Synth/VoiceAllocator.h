@@ -0,0 +1,476 @@
+/*
+  ==============================================================================
+
+    VoiceAllocator.h
+    Created: 17 Oct 2026 10:47:19pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/*
+    Picks the voice a new note goes to without looking through the voices. Works in slots (the voice's index in
+    the synth), GaySynth tells it when notes start, change key state and finish.
+
+    Free slots sit on a stack, so a note that finds one never searches. Sounding slots sit in one of three heaps
+    depending on their key:
+        released   - key up, quietest (amp env level) on top
+        sustained  - key up but held by the pedal, oldest on top
+        held       - key down, oldest on top
+    Stealing goes: the same note if it's still sounding, the quietest released voice, the oldest sustained one, the
+    oldest held one. The lowest and highest held notes are kept until nothing else is left (same as MPESynthesiser,
+    the bass note and the top line are what you'd hear drop out). Those two come from a bit per note, and finding the
+    oldest voice that isn't on one of them only has to step past the protected voices at the top of its heap.
+*/
+class VoiceAllocator
+{
+public:
+    static constexpr int maxVoices = 128;
+
+    VoiceAllocator()
+    {
+        std::fill(std::begin(noteSlots), std::end(noteSlots), -1);
+    }
+
+    enum class Pool
+    {
+        inactive,
+        held,
+        sustained,
+        released
+    };
+
+    // how many slots notes can go to (the polyphony). Sounding slots past it are left to finish and aren't handed out again
+    void setNumVoices(int newNumVoices)
+    {
+        numVoices = jlimit(0, maxVoices, newNumVoices);
+
+        numFree = 0;
+        released.clear();
+        sustained.clear();
+        held.clear();
+        heldNotes.fill(0);
+        heldBits.fill(0);
+
+        // slot 0 on top, the first notes go to the first voices
+        for (int slot = numVoices; --slot >= 0;)
+            if (pool[slot] == Pool::inactive)
+                pushFree(slot);
+
+        for (int i = 0; i < numActive; ++i)
+            enterPool(active[i]);
+    }
+
+    int getNumVoices() const
+    {
+        return numVoices;
+    }
+
+    // -1 if every slot is sounding
+    int getFreeVoice() const
+    {
+        return numFree > 0 ? freeSlots[numFree - 1] : -1;
+    }
+
+    // -1 if there's nothing to take (no slots at all)
+    int findVoiceToSteal(int noteNumber) const
+    {
+        if (isPositiveAndBelow(noteNumber, 128))
+        {
+            auto slot = noteSlots[noteNumber];
+            if (slot >= 0 && slot < numVoices && pool[slot] != Pool::inactive && notes[slot] == noteNumber)
+                return slot;
+        }
+
+        if (released.size > 0)
+            return released.top();
+
+        auto low = getLowestHeldNote();
+        auto high = getHighestHeldNote();
+        auto isUnprotected = [&](int slot) { return notes[slot] != low && notes[slot] != high; };
+
+        for (auto* heap : { &sustained, &held })
+        {
+            auto slot = heap->findTop(isUnprotected);
+            if (slot >= 0)
+                return slot;
+        }
+
+        // only the protected notes are left, the top one goes before the bass note
+        for (auto note : { high, low })
+        {
+            for (auto* heap : { &sustained, &held })
+            {
+                auto slot = heap->findTop([&](int s) { return notes[s] == note; });
+                if (slot >= 0)
+                    return slot;
+            }
+        }
+
+        return -1;
+    }
+
+    // the slot was handed a note, whatever it was doing before
+    void noteStarted(int slot, int noteNumber, uint16 noteID)
+    {
+        if (pool[slot] == Pool::inactive)
+        {
+            removeFree(slot);
+            activePositions[slot] = numActive;
+            active[numActive++] = slot;
+        }
+        else
+        {
+            leavePool(slot);
+        }
+
+        pool[slot] = Pool::held;
+        ages[slot] = nextAge++;
+        levels[slot] = 1.f;
+        notes[slot] = noteNumber;
+        noteIDs[slot] = noteID;
+
+        if (isPositiveAndBelow(noteNumber, 128))
+            noteSlots[noteNumber] = slot;
+
+        enterPool(slot);
+    }
+
+    void setPool(int slot, Pool newPool)
+    {
+        if (newPool == pool[slot])
+            return;
+
+        if (newPool == Pool::inactive)
+        {
+            voiceFinished(slot);
+            return;
+        }
+
+        if (pool[slot] == Pool::inactive)
+            return; // only noteStarted() brings a slot in
+
+        leavePool(slot);
+        pool[slot] = newPool;
+        enterPool(slot);
+    }
+
+    Pool getPool(int slot) const
+    {
+        return pool[slot];
+    }
+
+    // only matters for released slots, that's the heap it sorts
+    void setLevel(int slot, float level)
+    {
+        levels[slot] = level;
+
+        if (pool[slot] == Pool::released && released.contains(slot))
+            released.update(slot, level);
+    }
+
+    void voiceFinished(int slot)
+    {
+        if (pool[slot] == Pool::inactive)
+            return;
+
+        leavePool(slot);
+        pool[slot] = Pool::inactive;
+
+        auto position = activePositions[slot];
+        active[position] = active[--numActive];
+        activePositions[active[position]] = position;
+
+        if (isPositiveAndBelow(notes[slot], 128) && noteSlots[notes[slot]] == slot)
+            noteSlots[notes[slot]] = -1;
+
+        if (slot < numVoices)
+            pushFree(slot);
+    }
+
+    // the slot playing a note, -1 if none is. Same note twice at once (different channels) falls back to a search
+    int findSlot(int noteNumber, uint16 noteID) const
+    {
+        if (isPositiveAndBelow(noteNumber, 128))
+        {
+            auto slot = noteSlots[noteNumber];
+            if (slot >= 0 && noteIDs[slot] == noteID && pool[slot] != Pool::inactive)
+                return slot;
+        }
+
+        for (int i = 0; i < numActive; ++i)
+            if (noteIDs[active[i]] == noteID)
+                return active[i];
+
+        return -1;
+    }
+
+    // every sounding slot, in no particular order. Finishing one moves the last one into its place
+    int getNumActive() const
+    {
+        return numActive;
+    }
+
+    int getActive(int index) const
+    {
+        return active[index];
+    }
+
+private:
+    // min heap of slots that knows where each slot is, so any of them can be moved or taken out
+    template <typename Key>
+    struct SlotHeap
+    {
+        int slots[maxVoices];
+        int positions[maxVoices];
+        Key keys[maxVoices];
+        int size = 0;
+
+        SlotHeap()
+        {
+            clear();
+        }
+
+        void clear()
+        {
+            size = 0;
+            std::fill(std::begin(positions), std::end(positions), -1);
+        }
+
+        bool contains(int slot) const
+        {
+            return positions[slot] >= 0;
+        }
+
+        int top() const
+        {
+            return slots[0];
+        }
+
+        void push(int slot, Key key)
+        {
+            keys[slot] = key;
+            slots[size] = slot;
+            positions[slot] = size;
+            siftUp(size++);
+        }
+
+        void remove(int slot)
+        {
+            auto position = positions[slot];
+            positions[slot] = -1;
+
+            if (position == --size)
+                return;
+
+            // the last one fills the hole and goes whichever way it needs to
+            auto moved = slots[size];
+            slots[position] = moved;
+            positions[moved] = position;
+            siftUp(position);
+            siftDown(positions[moved]);
+        }
+
+        void update(int slot, Key key)
+        {
+            keys[slot] = key;
+            siftUp(positions[slot]);
+            siftDown(positions[slot]);
+        }
+
+        // the smallest slot that matches. Nothing under a matching slot can be smaller than it, so this only walks
+        // down past the ones that don't match - with the protected notes that's a handful at the top
+        template <typename Predicate>
+        int findTop(Predicate&& matches) const
+        {
+            int stack[maxVoices];
+            int numStacked = 0;
+            auto best = -1;
+
+            if (size > 0)
+                stack[numStacked++] = 0;
+
+            while (numStacked > 0)
+            {
+                auto i = stack[--numStacked];
+                auto slot = slots[i];
+
+                if (matches(slot))
+                {
+                    if (best < 0 || keys[slot] < keys[best])
+                        best = slot;
+
+                    continue;
+                }
+
+                for (auto child : { 2 * i + 1, 2 * i + 2 })
+                    if (child < size)
+                        stack[numStacked++] = child;
+            }
+
+            return best;
+        }
+
+    private:
+        bool less(int a, int b) const
+        {
+            return keys[slots[a]] < keys[slots[b]];
+        }
+
+        void swap(int a, int b)
+        {
+            std::swap(slots[a], slots[b]);
+            positions[slots[a]] = a;
+            positions[slots[b]] = b;
+        }
+
+        void siftUp(int i)
+        {
+            while (i > 0 && less(i, (i - 1) / 2))
+            {
+                swap(i, (i - 1) / 2);
+                i = (i - 1) / 2;
+            }
+        }
+
+        void siftDown(int i)
+        {
+            for (;;)
+            {
+                auto smallest = i;
+                auto left = 2 * i + 1, right = 2 * i + 2;
+
+                if (left < size && less(left, smallest))
+                    smallest = left;
+                if (right < size && less(right, smallest))
+                    smallest = right;
+
+                if (smallest == i)
+                    return;
+
+                swap(i, smallest);
+                i = smallest;
+            }
+        }
+    };
+
+    int numVoices = 0;
+
+    int freeSlots[maxVoices] {};
+    int freePositions[maxVoices] {};
+    int numFree = 0;
+
+    int active[maxVoices] {};
+    int activePositions[maxVoices] {};
+    int numActive = 0;
+
+    Pool pool[maxVoices] {};
+    uint32 ages[maxVoices] {};
+    float levels[maxVoices] {};
+    int notes[maxVoices] {};
+    uint16 noteIDs[maxVoices] {};
+    uint32 nextAge = 0;
+
+    int noteSlots[128]; // the last slot each note started on, -1 for none
+
+    SlotHeap<float> released;
+    SlotHeap<uint32> sustained, held;
+
+    // held / sustained slots inside the limit on each note, and a bit for every note that has any
+    std::array<uint8, 128> heldNotes {};
+    std::array<uint32, 4> heldBits {};
+
+    void pushFree(int slot)
+    {
+        freePositions[slot] = numFree;
+        freeSlots[numFree++] = slot;
+    }
+
+    void removeFree(int slot)
+    {
+        auto position = freePositions[slot];
+        if (position >= numFree || freeSlots[position] != slot)
+            return; // past the limit, never went on the stack
+
+        freeSlots[position] = freeSlots[--numFree];
+        freePositions[freeSlots[position]] = position;
+    }
+
+    void enterPool(int slot)
+    {
+        if (slot >= numVoices)
+            return;
+
+        switch (pool[slot])
+        {
+        case Pool::released:    released.push(slot, levels[slot]); break;
+        case Pool::sustained:   sustained.push(slot, ages[slot]); addHeldNote(notes[slot]); break;
+        case Pool::held:        held.push(slot, ages[slot]); addHeldNote(notes[slot]); break;
+        case Pool::inactive:    break;
+        }
+    }
+
+    void leavePool(int slot)
+    {
+        switch (pool[slot])
+        {
+        case Pool::released:
+            if (released.contains(slot))
+                released.remove(slot);
+            break;
+
+        case Pool::sustained:
+            if (sustained.contains(slot))
+            {
+                sustained.remove(slot);
+                removeHeldNote(notes[slot]);
+            }
+            break;
+
+        case Pool::held:
+            if (held.contains(slot))
+            {
+                held.remove(slot);
+                removeHeldNote(notes[slot]);
+            }
+            break;
+
+        case Pool::inactive:
+            break;
+        }
+    }
+
+    void addHeldNote(int note)
+    {
+        if (isPositiveAndBelow(note, 128) && heldNotes[(size_t)note]++ == 0)
+            heldBits[(size_t)note / 32] |= (uint32)1 << (note % 32);
+    }
+
+    void removeHeldNote(int note)
+    {
+        if (isPositiveAndBelow(note, 128) && --heldNotes[(size_t)note] == 0)
+            heldBits[(size_t)note / 32] &= ~((uint32)1 << (note % 32));
+    }
+
+    // -1 when nothing's held
+    int getLowestHeldNote() const
+    {
+        for (int word = 0; word < 4; ++word)
+            if (auto bits = heldBits[(size_t)word])
+                return word * 32 + findHighestSetBit(bits & (~bits + 1)); // just the lowest bit left
+
+        return -1;
+    }
+
+    int getHighestHeldNote() const
+    {
+        for (int word = 4; --word >= 0;)
+            if (auto bits = heldBits[(size_t)word])
+                return word * 32 + findHighestSetBit(bits);
+
+        return -1;
+    }
+};
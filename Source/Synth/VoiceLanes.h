@@ -0,0 +1,250 @@
+/*
+  ==============================================================================
+
+    VoiceLanes.h
+    Created: 17 Oct 2026 5:12:40pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../WaveTable/WaveTableVector.h"
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+ #include <immintrin.h>
+#endif
+
+/*
+    Lane engine: runs the wavetable part of several oscillators at once, one oscillator per simd lane.
+    GaySynth packs every active oscillator into groups of laneWidth (see GaySynth::EngineMode), each voice still does its own
+    controls, gain, mix and filter around it.
+
+    The lane width is picked at compile time from whatever the build targets:
+        AVX-512 -> 16, AVX2 -> 8, SSE2 / NEON -> 4, anything else -> 1 (plain scalar)
+    The per lane maths is written as plain loops over the lanes so the compiler turns them into vector ops,
+    the table reads (every lane reads a different table) are real gathers on AVX2 / AVX-512 and scalar loads otherwise.
+
+    Unlike the per voice path each oscillator reads a single mip level (WaveTable::getMipLevel) without fading to the
+    next, so the sound is close to but not sample identical with the normal engine. Reference quality never uses it.
+    Every group reads with one interpolation kernel (TableInterpolation), a kernel with more taps is a gather per tap.
+*/
+class VoiceLanes
+{
+public:
+   #if defined(__AVX512F__)
+    static constexpr int laneWidth = 16;
+   #elif defined(__AVX2__)
+    static constexpr int laneWidth = 8;
+   #elif defined(__SSE2__) || defined(_M_X64) || defined(__ARM_NEON)
+    static constexpr int laneWidth = 4;
+   #else
+    static constexpr int laneWidth = 1;
+   #endif
+
+    // one oscillator's worth of work for this block
+    struct Lane
+    {
+        WaveTableVector* vector = nullptr;
+        const float* wave = nullptr;    // wave position per sample, 0 - 1
+        const float* pitch = nullptr;   // frequency per sample
+        float* output = nullptr;
+        int numSamples = 0;             // the voice's amp env can finish before the end of the block
+    };
+
+    void process(const Lane* lanes, int numLanes, TableInterpolation::Kernel kernel = TableInterpolation::Kernel::linear)
+    {
+        TableInterpolation::dispatch(kernel, [&](auto k)
+        {
+            for (int first = 0; first < numLanes; first += laneWidth)
+                processGroup<decltype(k)>(lanes + first, jmin(laneWidth, numLanes - first));
+        });
+    }
+
+private:
+    static constexpr int tableSize = 2048;
+
+    alignas(64) float phase[laneWidth], delta[laneWidth];
+    alignas(64) float mipDelta[laneWidth], mipScale[laneWidth];
+    alignas(64) int mipLevel[laneWidth], mipMask[laneWidth];
+    alignas(64) float wavePos[laneWidth], waveTarget[laneWidth], waveStep[laneWidth], waveRange[laneWidth];
+    alignas(64) int waveCountdown[laneWidth], smoothingSteps[laneWidth], laneLength[laneWidth], lastTable[laneWidth];
+    alignas(64) float phaseScale[laneWidth], interp[laneWidth], frac[laneWidth];
+    alignas(64) int index0[laneWidth], index1[laneWidth], tapIndex[laneWidth];
+    alignas(64) const float* lower[laneWidth];
+    alignas(64) const float* upper[laneWidth];
+    alignas(64) float lower0[laneWidth], lower1[laneWidth], upper0[laneWidth], upper1[laneWidth];
+    alignas(64) float lowerSum[laneWidth], upperSum[laneWidth];
+
+    // the table / frequency lookups are tiny next to everything else, unused lanes point at lane 0 and just never get written out
+    template <typename Kernel>
+    void processGroup(const Lane* lanes, int numUsed)
+    {
+        int longest = 0;
+
+        for (int l = 0; l < laneWidth; ++l)
+        {
+            auto& lane = lanes[l < numUsed ? l : 0];
+            auto& state = lane.vector->getLaneState();
+            auto arraySize = jmax(1, lane.vector->getArraySize());
+
+            phase[l] = lane.vector->getPhase();
+            wavePos[l] = state.wavePos;
+            waveTarget[l] = state.waveTarget;
+            waveStep[l] = state.waveStep;
+            waveCountdown[l] = state.waveCountdown;
+            waveRange[l] = (float)arraySize - 1.f;
+            lastTable[l] = arraySize - 1;
+            smoothingSteps[l] = (int)std::floor(0.01 * lane.vector->getSampleRate());
+            phaseScale[l] = (float)((double)tableSize / lane.vector->getSampleRate());
+            laneLength[l] = l < numUsed ? lane.numSamples : 0;
+            longest = jmax(longest, laneLength[l]);
+            mipDelta[l] = -1.f;
+        }
+
+        for (int i = 0; i < longest; ++i)
+        {
+            // wave position smoothing, the same linear ramp SmoothedValue does
+            for (int l = 0; l < laneWidth; ++l)
+            {
+                auto sampleIndex = jmin(i, jmax(0, laneLength[l] - 1));
+                auto target = lanes[l < numUsed ? l : 0].wave[sampleIndex] * waveRange[l];
+
+                if (i < laneLength[l] && target != waveTarget[l])
+                {
+                    waveTarget[l] = target;
+                    waveCountdown[l] = smoothingSteps[l];
+                    waveStep[l] = smoothingSteps[l] > 0 ? (target - wavePos[l]) / (float)smoothingSteps[l] : 0.f;
+                }
+            }
+
+            for (int l = 0; l < laneWidth; ++l)
+            {
+                // lanes whose voice has finished for this block hold still
+                auto active = i < laneLength[l];
+                auto smoothing = active && waveCountdown[l] > 0;
+                waveCountdown[l] -= smoothing ? 1 : 0;
+                wavePos[l] = (smoothing && waveCountdown[l] > 0) ? wavePos[l] + waveStep[l] : (active ? waveTarget[l] : wavePos[l]);
+
+                auto lowerIndex = (int)wavePos[l];
+                auto upperIndex = lowerIndex + 1 > lastTable[l] ? 0 : lowerIndex + 1;
+                interp[l] = wavePos[l] - (float)lowerIndex;
+
+                auto sampleIndex = jmin(i, jmax(0, laneLength[l] - 1));
+                delta[l] = active ? lanes[l < numUsed ? l : 0].pitch[sampleIndex] * phaseScale[l] : 0.f;
+
+                // the level only changes when the pitch does, both tables at one level are the same size
+                if (delta[l] != mipDelta[l])
+                {
+                    float fade;
+                    mipDelta[l] = delta[l];
+                    mipLevel[l] = WaveTable::getMipLevel(delta[l], fade);
+                }
+
+                auto* vector = lanes[l < numUsed ? l : 0].vector;
+                auto& lowerMip = vector->getTable(lowerIndex).getMip(mipLevel[l]);
+                lower[l] = lowerMip.data;
+                upper[l] = vector->getTable(upperIndex).getMip(mipLevel[l]).data;
+                mipScale[l] = lowerMip.scale;
+                mipMask[l] = lowerMip.mask;
+
+                auto position = phase[l] * mipScale[l];
+                index0[l] = (int)position;
+                frac[l] = position - (float)index0[l];
+                index0[l] &= mipMask[l];
+                index1[l] = (index0[l] + 1) & mipMask[l];
+            }
+
+            if constexpr (std::is_same_v<Kernel, TableInterpolation::Linear>)
+            {
+                gather(lower0, lower, index0);
+                gather(lower1, lower, index1);
+                gather(upper0, upper, index0);
+                gather(upper1, upper, index1);
+
+                for (int l = 0; l < laneWidth; ++l)
+                {
+                    lowerSum[l] = lower0[l] + frac[l] * (lower1[l] - lower0[l]);
+                    upperSum[l] = upper0[l] + frac[l] * (upper1[l] - upper0[l]);
+                }
+            }
+            else
+            {
+                for (int l = 0; l < laneWidth; ++l)
+                    lowerSum[l] = upperSum[l] = 0.f;
+
+                addTaps<Kernel>(std::make_integer_sequence<int, Kernel::numTaps>());
+            }
+
+            for (int l = 0; l < laneWidth; ++l)
+            {
+                lower0[l] = lowerSum[l] * (1.f - interp[l]) + upperSum[l] * interp[l];
+
+                phase[l] += delta[l];
+                phase[l] = phase[l] >= (float)tableSize ? phase[l] - (float)tableSize : phase[l];
+            }
+
+            for (int l = 0; l < numUsed; ++l)
+                if (i < laneLength[l])
+                    lanes[l].output[i] = lower0[l];
+        }
+
+        for (int l = 0; l < numUsed; ++l)
+        {
+            auto& state = lanes[l].vector->getLaneState();
+            lanes[l].vector->setPhase(phase[l]);
+            state.wavePos = wavePos[l];
+            state.waveTarget = waveTarget[l];
+            state.waveStep = waveStep[l];
+            state.waveCountdown = waveCountdown[l];
+        }
+    }
+
+    template <typename Kernel, int... taps>
+    void addTaps(std::integer_sequence<int, taps...>)
+    {
+        (addTap<Kernel, taps>(), ...);
+    }
+
+    // one tap of a wider kernel for every lane, both tables
+    template <typename Kernel, int tap>
+    void addTap()
+    {
+        for (int l = 0; l < laneWidth; ++l)
+            tapIndex[l] = (index0[l] + Kernel::firstTap + tap) & mipMask[l];
+
+        gather(lower0, lower, tapIndex);
+        gather(upper0, upper, tapIndex);
+
+        for (int l = 0; l < laneWidth; ++l)
+        {
+            auto weight = Kernel::template weight<tap>(frac[l]);
+            lowerSum[l] += weight * lower0[l];
+            upperSum[l] += weight * upper0[l];
+        }
+    }
+
+    // dest[l] = tables[l][indices[l]]
+    static void gather(float* dest, const float* const* tables, const int* indices)
+    {
+       #if defined(__AVX512F__)
+        for (int l = 0; l < laneWidth; l += 8)
+        {
+            auto base = _mm512_loadu_si512((const void*)(tables + l));
+            auto offsets = _mm512_slli_epi64(_mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)(indices + l))), 2);
+            _mm256_storeu_ps(dest + l, _mm512_i64gather_ps(_mm512_add_epi64(base, offsets), nullptr, 1));
+        }
+       #elif defined(__AVX2__)
+        for (int l = 0; l < laneWidth; l += 4)
+        {
+            auto base = _mm256_loadu_si256((const __m256i*)(tables + l));
+            auto offsets = _mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(indices + l))), 2);
+            _mm_storeu_ps(dest + l, _mm256_i64gather_ps(nullptr, _mm256_add_epi64(base, offsets), 1));
+        }
+       #else
+        for (int l = 0; l < laneWidth; ++l)
+            dest[l] = tables[l][indices[l]];
+       #endif
+    }
+};
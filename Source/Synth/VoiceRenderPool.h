@@ -0,0 +1,248 @@
+/*
+  ==============================================================================
+
+    VoiceRenderPool.h
+    Created: 17 Oct 2026 6:20:14pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "../Processor/RealtimeSanitizer.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+/*
+    Worker threads for GaySynth::EngineMode::parallel.
+    The audio thread hands run() a job and a number of pieces, then works through them itself alongside the workers,
+    so a block never waits on a thread that's asleep - at worst the audio thread ends up doing everything.
+
+    Scheduling is lock free work stealing over fixed ranges: every participant (the audio thread is participant 0)
+    gets an even share of the piece indices and claims from the front of its own range with a fetch_add, once
+    that runs dry it claims from everyone else's the same way. Pieces are small and few (a handful of voices each)
+    so there's no need for a real deque.
+
+    Workers are pinned one per core (skipping core 0, hosts tend to put their audio thread there), spin for a while
+    after every block in case the next one comes quickly, then park on a condition variable with a timeout.
+    The audio thread only notifies when someone is parked, and a wake up it misses just costs that block's
+    parallelism, the timeout bounds how long a worker stays out of it.
+
+    start() / stop() make and join threads, message thread only and never while run() could be going.
+*/
+class VoiceRenderPool
+{
+public:
+    struct Job
+    {
+        virtual ~Job() = default;
+        // called from the audio thread and the workers at the same time. participant is 0 on the audio thread,
+        // 1 - getNumWorkers() on the workers, for anything that needs its own scratch per thread
+        virtual void perform(int pieceIndex, int participant) = 0;
+    };
+
+    static constexpr int maxParticipants = 64; // the audio thread and up to 63 workers
+
+    VoiceRenderPool() = default;
+
+    ~VoiceRenderPool()
+    {
+        stop();
+    }
+
+    static int getDefaultNumWorkers()
+    {
+        return jlimit(0, maxWorkers, SystemStats::getNumPhysicalCpus() - 1);
+    }
+
+    void start(int numWorkersToUse)
+    {
+        stop();
+
+        numWorkers = jlimit(0, maxWorkers, numWorkersToUse);
+        shouldExit = false;
+
+        for (int i = 0; i < numWorkers; ++i)
+            workers[(size_t)i] = std::thread([this, i] { workerLoop(i + 1); });
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            shouldExit = true;
+        }
+        parkCondition.notify_all();
+
+        for (int i = 0; i < numWorkers; ++i)
+            if (workers[(size_t)i].joinable())
+                workers[(size_t)i].join();
+
+        numWorkers = 0;
+    }
+
+    int getNumWorkers() const
+    {
+        return numWorkers;
+    }
+
+    // audio thread, returns once every piece has been performed
+    void run(Job& job, int numPieces)
+    {
+        if (numPieces <= 0)
+            return;
+
+        auto numParticipants = numWorkers + 1;
+
+        for (int p = 0; p < numParticipants; ++p)
+        {
+            auto& range = ranges[(size_t)p];
+            range.next.store(numPieces * p / numParticipants, std::memory_order_relaxed);
+            range.end = numPieces * (p + 1) / numParticipants;
+        }
+
+        currentJob = &job;
+        participants = numParticipants;
+        remaining.store(numPieces, std::memory_order_relaxed);
+        open.store(true);
+
+        generation.fetch_add(1);
+        if (numParked.load() > 0)
+            parkCondition.notify_all();
+
+        performPieces(0);
+
+        while (remaining.load(std::memory_order_acquire) > 0)
+            pause();
+
+        // nobody new gets in once it's closed, then wait for whoever's still on their way out
+        open.store(false);
+
+        while (busy.load() > 0)
+            pause();
+    }
+
+private:
+    static constexpr int maxWorkers = maxParticipants - 1;
+    static constexpr int spinIterations = 20000;
+    static constexpr auto parkTimeout = std::chrono::milliseconds(1);
+
+    struct alignas(64) Range
+    {
+        std::atomic<int> next { 0 };
+        int end = 0;
+    };
+
+    std::array<std::thread, (size_t)maxWorkers> workers;
+    std::array<Range, (size_t)maxWorkers + 1> ranges;
+    int numWorkers = 0;
+
+    Job* currentJob = nullptr;
+    int participants = 1;
+
+    alignas(64) std::atomic<int> remaining { 0 };
+    alignas(64) std::atomic<int> busy { 0 };
+    std::atomic<bool> open { false };
+    std::atomic<uint32> generation { 0 };
+
+    std::atomic<int> numParked { 0 };
+    std::mutex parkMutex;
+    std::condition_variable parkCondition;
+    std::atomic<bool> shouldExit { false };
+
+    static void pause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (JUCE_GCC || JUCE_CLANG)
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+
+    bool tryClaim(int participant, int& piece)
+    {
+        auto& range = ranges[(size_t)participant];
+        piece = range.next.fetch_add(1, std::memory_order_relaxed);
+        return piece < range.end;
+    }
+
+    // own range first, then steal from the others starting with the next one along
+    void performPieces(int self)
+    {
+        auto numParticipants = participants;
+
+        for (int offset = 0; offset < numParticipants; ++offset)
+        {
+            auto victim = (self + offset) % numParticipants;
+            int piece = 0;
+
+            while (tryClaim(victim, piece))
+            {
+                currentJob->perform(piece, self);
+                remaining.fetch_sub(1, std::memory_order_release);
+            }
+        }
+    }
+
+    void workerLoop(int self)
+    {
+        auto numCores = SystemStats::getNumCpus();
+        if (numCores > 1 && numCores <= 32)
+            Thread::setCurrentThreadAffinityMask((uint32)1 << (uint32)(1 + (self - 1) % (numCores - 1)));
+
+        uint32 seen = generation.load();
+
+        for (;;)
+        {
+            if (! waitForWork(seen))
+                return;
+
+            seen = generation.load();
+
+            // busy goes up before open is checked, so run() can't slip past its busy check while a worker is joining
+            busy.fetch_add(1);
+
+            if (open.load())
+            {
+                GPC_RT_AUDIO_SCOPE
+                ScopedNoDenormals noDenormals;
+                performPieces(self);
+            }
+
+            busy.fetch_sub(1);
+        }
+    }
+
+    // false when the pool is stopping
+    bool waitForWork(uint32 seen)
+    {
+        for (int i = 0; i < spinIterations; ++i)
+        {
+            if (shouldExit.load(std::memory_order_relaxed))
+                return false;
+
+            if (generation.load(std::memory_order_relaxed) != seen)
+                return true;
+
+            pause();
+        }
+
+        std::unique_lock<std::mutex> lock(parkMutex);
+        ++numParked;
+
+        while (! shouldExit && generation.load() == seen)
+            parkCondition.wait_for(lock, parkTimeout);
+
+        --numParked;
+        return ! shouldExit;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(VoiceRenderPool)
+};
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    BankSwap.h
+    Created: 18 Oct 2026 12:21:45am
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "WavetableBank.h"
+
+/*
+    Gets a new bank from whichever thread built it to the audio thread, and the old one back out again, without
+    either side ever waiting on the other.
+
+    publish() drops the bank in a single atomic slot, a newer one replaces whatever the audio thread hasn't picked up
+    yet. The audio thread only looks at the slot in beginBlock(), so banks change on block boundaries. It keeps the
+    bank it's leaving for the crossfade, then hands it back through a fifo instead of letting go of it, since the last
+    reference going would free it on the audio thread. collectGarbage() lets go of them on the publishing side, every
+    publish() does that first.
+
+    That's an epoch scheme with one reader: the audio thread is the only thing that reads banks out of the voices,
+    and a bank only goes on the fifo once a block boundary has passed with no voice pointing at it any more.
+*/
+class BankSwap
+{
+public:
+    BankSwap()
+    {
+        retired.fill(nullptr);
+    }
+
+    ~BankSwap()
+    {
+        collectGarbage();
+        release(pending.exchange(nullptr));
+        release(current);
+        release(previous);
+    }
+
+    // any thread but the audio one. The bank has to be completely built, nothing changes it after this
+    void publish(WavetableBank::Ptr bank)
+    {
+        collectGarbage();
+
+        if (bank == nullptr)
+            bank = WavetableBank::createEmpty();
+
+        bank->incReferenceCount(); // the slot's reference, the audio thread takes it over
+        release(pending.exchange(bank.get(), std::memory_order_acq_rel));
+    }
+
+    // any thread but the audio one, lets go of the banks the audio thread is done with
+    void collectGarbage()
+    {
+        const ScopedLock sl(collectLock);
+
+        int start1, size1, start2, size2;
+        retiredFifo.prepareToRead(retiredFifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            release(std::exchange(retired[(size_t)(start1 + i)], nullptr));
+        for (int i = 0; i < size2; ++i)
+            release(std::exchange(retired[(size_t)(start2 + i)], nullptr));
+
+        retiredFifo.finishedRead(size1 + size2);
+    }
+
+    /*
+        Audio thread, at the start of every block, before anything renders.
+        finishFade() - every voice stops reading the bank it was fading out of
+        startFade(bank, fadeLength) - every voice starts on bank, fading out of the one it had over fadeLength samples
+        The first bank ever comes in without a fade. A bank published mid fade cuts the old fade short
+    */
+    template <typename FinishFade, typename StartFade>
+    void beginBlock(int numSamples, int fadeLength, FinishFade&& finishFade, StartFade&& startFade)
+    {
+        auto* next = pending.exchange(nullptr, std::memory_order_acq_rel);
+
+        if (isFading && (next != nullptr || fadeElapsed >= fadeLength))
+        {
+            finishFade();
+            retire(previous);
+            previous = nullptr;
+            isFading = false;
+        }
+
+        if (next != nullptr)
+        {
+            auto shouldFade = current != nullptr && fadeLength > 0;
+            startFade(next, shouldFade ? fadeLength : 0);
+
+            if (shouldFade)
+                previous = current;
+            else
+                retire(current);
+
+            current = next;
+            isFading = shouldFade;
+            fadeElapsed = 0;
+        }
+
+        fadeElapsed += numSamples;
+    }
+
+private:
+    static constexpr int retiredCapacity = 32;
+
+    std::atomic<WavetableBank*> pending { nullptr };
+
+    // audio thread only
+    WavetableBank* current = nullptr;
+    WavetableBank* previous = nullptr;
+    bool isFading = false;
+    int fadeElapsed = 0;
+
+    // audio thread -> collectGarbage()
+    AbstractFifo retiredFifo { retiredCapacity };
+    std::array<WavetableBank*, retiredCapacity> retired;
+    CriticalSection collectLock; // never taken by the audio thread
+
+    void retire(WavetableBank* bank)
+    {
+        if (bank == nullptr)
+            return;
+
+        int start1, size1, start2, size2;
+        retiredFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        // every publish() empties the fifo and only a publish can make the audio thread retire something, so it
+        // can't fill up. If it somehow did the bank is leaked rather than freed here
+        jassert(size1 + size2 == 1);
+
+        if (size1 + size2 == 0)
+            return;
+
+        retired[(size_t)(size1 > 0 ? start1 : start2)] = bank;
+        retiredFifo.finishedWrite(1);
+    }
+
+    static void release(WavetableBank* bank)
+    {
+        if (bank != nullptr)
+            bank->decReferenceCount();
+    }
+};
@@ -10,6 +10,7 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "TableInterpolation.h"
 
 class WaveTable
 {
@@ -20,9 +21,29 @@ public:
     WaveTable(int lengthInSamples = 2048) : waveBuffer(1, lengthInSamples)
     {
         tableSize = lengthInSamples;
+        mips[0] = { waveBuffer.getReadPointer(0), tableSize - 1, 1.f };
     }
 
+    /*
+        A table that plays samples living somewhere else (a mapped WavetableCache) rather than its own, nothing's
+        copied. samples is the table, levels is every level past 0 back to back (getMipStorageSize). Both have to
+        outlive it and never change, it only ever reads them
+    */
+    WaveTable(const float* samples, const float* levels, int lengthInSamples)
+        : waveBuffer(const_cast<float* const*>(&samples), 1, lengthInSamples)
+    {
+        tableSize = lengthInSamples;
+        mips[0] = { samples, tableSize - 1, 1.f };
 
+        for (int k = 1; k < numMipLevels; ++k)
+        {
+            auto size = getMipSize(k, tableSize);
+            mips[(size_t)k] = { levels, size - 1, (float)size / (float)tableSize };
+            levels += size;
+        }
+
+        numMips = numMipLevels;
+    }
 
     ~WaveTable() {}
 
@@ -54,32 +75,165 @@ public:
 
 
         buffWrite[tableSize] = buffWrite[0];
+        mips[0] = { waveBuffer.getReadPointer(0), tableSize - 1, 1.f };
+        numMips = 1;
     }
 
-    float getNextSample()
+    //==============================================================================
+    /*
+        Band limited copies of the table, one per octave. Level k keeps the first (tableSize / 2) >> k harmonics,
+        so it plays without aliasing while the phase moves less than 2^(k - 1) samples of the full table per sample.
+        Level 0 is the table itself. Past level 1 they're stored smaller, 4 samples per cycle of their top harmonic
+        (never under minMipSize), and read at phase * scale so everything still runs one phase over tableSize.
+    */
+    static constexpr int numMipLevels = 11; // 2048 sample tables, down to a sine
+    static constexpr int minMipSize = 256;
+
+    struct Mip
+    {
+        const float* data = nullptr;
+        int mask = 0;       // size - 1, sizes are powers of two
+        float scale = 1.f;  // size / tableSize
+
+        // the level at a phase over the full table, read between samples with Kernel (TableInterpolation)
+        template <typename Kernel = TableInterpolation::Linear>
+        float read(float phase) const
+        {
+            auto position = phase * scale;
+            auto index0 = (int)position;
+            auto frac = position - (float)index0;
+
+            return Kernel::read(data, mask, index0, frac);
+        }
+    };
+
+    static int getMipSize(int level, int fullSize = 2048)
+    {
+        return level == 0 ? fullSize : jmin(fullSize, jmax(minMipSize, (fullSize * 2) >> level));
+    }
+
+    // every level past 0 together, in samples
+    static int getMipStorageSize(int fullSize = 2048)
+    {
+        int size = 0;
+        for (int k = 1; k < numMipLevels; ++k)
+            size += getMipSize(k, fullSize);
+        return size;
+    }
+
+    /*
+        The level to read at a phase increment (table samples per output sample) and how far to fade towards the
+        next one up. The lower level is already alias free, the fade only takes out harmonics sitting between a
+        quarter of the sample rate and nyquist, so the step at every octave is smoothed over without anything folding
+    */
+    static int getMipLevel(float delta, float& fade)
+    {
+        fade = 0.f;
+
+        if (delta < 0.5f)
+            return 0;
+
+        auto position = std::log2(2.f * delta);
+        auto level = (int)position;
+
+        if (level >= numMipLevels - 1)
+            return numMipLevels - 1;
+
+        fade = position - (float)level;
+        return level;
+    }
+
+    // levels that haven't been built (tables that never went through buildMips, like the lfos) read the table itself
+    const Mip& getMip(int level) const
+    {
+        return mips[(size_t)jmin(level, numMips - 1)];
+    }
+
+    /*
+        FFTs the table and resynthesises each level from its share of the harmonics. Call whenever the table's samples
+        change. Message thread, the first build allocates the levels, later ones reuse them
+    */
+    void buildMips()
+    {
+        jassert(isPowerOfTwo(tableSize) && tableSize >= minMipSize);
+
+        auto order = (int)std::log2(tableSize);
+        dsp::FFT forward(order);
+
+        HeapBlock<float> spectrum((size_t)tableSize * 2, true);
+        HeapBlock<float> level((size_t)tableSize * 2);
+        FloatVectorOperations::copy(spectrum, waveBuffer.getReadPointer(0), tableSize);
+        forward.performRealOnlyForwardTransform(spectrum, true);
+
+        allocateMips();
+
+        auto* dest = mipData.get();
+
+        for (int k = 1; k < numMipLevels; ++k)
+        {
+            auto size = getMipSize(k, tableSize);
+            auto harmonics = (tableSize / 2) >> k;
+            dsp::FFT inverse((int)std::log2(size));
+
+            // juce's inverse divides by its own size, the forward one didn't divide at all
+            FloatVectorOperations::clear(level, size * 2);
+            FloatVectorOperations::copyWithMultiply(level, spectrum, (float)size / (float)tableSize, (harmonics + 1) * 2);
+            inverse.performRealOnlyInverseTransform(level);
+
+            FloatVectorOperations::copy(dest, level, size);
+            mips[(size_t)k] = { dest, size - 1, (float)size / (float)tableSize };
+            dest += size;
+        }
+
+        numMips = numMipLevels;
+    }
+
+    // the table at a phase someone else keeps (WaveTableVector), faded fade of the way from level to the next one up
+    template <typename Kernel = TableInterpolation::Linear>
+    float read(float phase, int level, float fade) const
     {
-        auto index0 = (unsigned int)currentIndex;
+        auto sample = getMip(level).read<Kernel>(phase);
 
-        auto frac = currentIndex - (float)index0;
-        auto* table = waveBuffer.getReadPointer(0);
+        if (fade > 0.f)
+            sample += fade * (getMip(level + 1).read<Kernel>(phase) - sample);
 
-        auto value0 = table[index0];
-        auto value1 = table[index0 + 1];
+        return sample;
+    }
+
+    //==============================================================================
+    // the table playing itself on its own phase, what the lfos use. They stay linear, anything else is wasted on an lfo
+    template <typename Kernel = TableInterpolation::Linear>
+    float getNextSample()
+    {
+        if (tableDelta != mipDelta)
+        {
+            mipDelta = tableDelta;
+            mipLevel = getMipLevel(tableDelta, mipFade);
+        }
 
-        currentSample = value0 + (frac * (value1 - value0));
+        currentSample = read<Kernel>(currentIndex, mipLevel, mipFade);
 
         currentSample *= gain;
 
         currentIndex += tableDelta;
 
-        if (currentIndex > (float)waveBuffer.getNumSamples())
+        // wrapped rather than restarted, so the cycle doesn't jump (that alone would alias)
+        if (currentIndex >= (float)tableSize)
         {
-            currentIndex = 0;
+            currentIndex -= (float)tableSize;
         }
 
         return currentSample;
     }
 
+    // control rate version of getNextSample(), moves on numSamples steps at once and reads where the last one would have
+    float advance(int numSamples)
+    {
+        // wraps at the table size like getNextSample() does, one short would lose a sample of phase every cycle
+        currentIndex = std::fmod(currentIndex + tableDelta * (float)(numSamples - 1), (float)tableSize);
+        return getNextSample();
+    }
+
     // way of getting sample without increment
     float getCurrentSample()
     {
@@ -98,6 +252,11 @@ public:
         return waveBuffer;
     }
 
+    const AudioBuffer<float>& getBuffer() const
+    {
+        return waveBuffer;
+    }
+
     // specifically for visualizer (exists in case user dropped in a wavetable of a different size)
     AudioBuffer<float>& getMappedBuffer()
     {
@@ -123,8 +282,10 @@ public:
             auto readIndex = i * sizeRatio;
             float frac = readIndex - (int)readIndex; 
 
+            // it's one cycle, the last sample leads back round to the first
+            auto nextIndex = (int)readIndex + 1 < newTable.getNumSamples() ? (int)readIndex + 1 : 0;
             float readSample0 = buffRead[0][(int)readIndex] * (1 - frac);
-            float readSample1 = buffRead[0][(int)readIndex + 1] * frac;
+            float readSample1 = buffRead[0][nextIndex] * frac;
             float readSample = readSample0 + readSample1;
               
             buffWrite[0][i] = readSample;
@@ -137,10 +298,34 @@ public:
     {
         gain = gainVal;
     }
+
+    // when used as an lfo the voice renders a block of it ahead of time (GayVoice::renderControls), GayParam reads that block from here
+    void setBlockBuffer(float* buffer)
+    {
+        blockBuffer = buffer;
+    }
+
+    const float* getBlockBuffer() const
+    {
+        return blockBuffer;
+    }
 private:
     juce::AudioBuffer<float> waveBuffer;
     int tableSize = 2048;
     double mSampleRate = 48000;
     float tableDelta = 0.f, currentIndex = 0.f, currentSample = 0.f;
     float gain = 1.f;
+    float* blockBuffer = nullptr;
+
+    std::array<Mip, numMipLevels> mips;
+    HeapBlock<float> mipData; // every level past 0 back to back
+    int numMips = 1;
+    float mipDelta = -1.f, mipFade = 0.f; // the level is only worked out again when the frequency changes
+    int mipLevel = 0;
+
+    void allocateMips()
+    {
+        if (mipData == nullptr)
+            mipData.malloc((size_t)getMipStorageSize(tableSize));
+    }
 };
\ No newline at end of file
@@ -1,7 +1,7 @@
 /*
   ==============================================================================
 
-    FileLoader.h
+    WaveTableLoader.h
     Created: 21 Oct 2021 8:41:19pm
     Author:  ryand
 
@@ -10,23 +10,371 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "WavetableBank.h"
+#include "WavetableParser.h"
+#include "WavetableCache.h"
 
 /*
-    Loader for wavetable that can handle resizing and cutting off at zero crossings
+    Builds every wavetable bank in the background, so nothing the editor does waits on a file.
+
+    Each way of changing an oscillator's tables is a request: load files / a folder, add single cycles, cut a
+    recording into cycles, clear. Requests go on a queue and a few worker threads decode them, a big folder is
+    split over all of them a file at a time. A folder's frames are cached after the first time (WavetableCache),
+    from then on it's mapped rather than decoded. Whatever finishes first, the banks come out in the order the requests
+    went in - each one is built on top of the last bank that oscillator got, then handed to publishBank (the synth).
+
+    A request that replaces an oscillator's tables (a folder, clear) cancels everything still queued for it, that's
+    the user picking another table before the last one finished. getStatus() is for the editor, which polls it.
 */
 class WaveTableLoader
 {
 public:
-    WaveTableLoader()
+    using PublishBank = std::function<void(int oscNum, WavetableBank::Ptr bank)>;
+    using Frames = std::vector<WavetableBank::Frame::Ptr>;
+
+    struct Status
+    {
+        bool isLoading = false;
+        float progress = 0.f;   // 0 - 1 over everything queued for the oscillator
+        String name;            // the oldest thing still loading
+    };
+
+    // publishBank gets called from the worker threads
+    WaveTableLoader(PublishBank publishBank)
+        : publish(std::move(publishBank)), numWorkers(jlimit(1, 4, SystemStats::getNumCpus() - 1)), pool(numWorkers)
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    ~WaveTableLoader()
     {
-       // formatManager.registerBasicFormats();
+        cancel(0);
+        pool.removeAllJobs(true, -1);
     }
-    ~WaveTableLoader(){}
 
-        
-        
+    //==============================================================================
+    // all message thread, oscNum 0 means both oscillators
+
+    // a folder replaces the tables with every .wav under it, a single .wav goes on the end (see WavetableBank::load)
+    void loadFiles(const StringArray& files, int oscNum)
+    {
+        auto replaces = false;
+        for (auto& path : files)
+            replaces = replaces || File(path).isDirectory();
+
+        addRequest(oscNum, replaces, File(files[files.size() - 1]).getFileNameWithoutExtension(), [this, files](Request& request)
+        {
+            std::vector<Decode> items;
+
+            for (auto& path : files)
+            {
+                File file(path);
+
+                if (file.isDirectory())
+                {
+                    items.clear();
+                    request.cacheFile = File();
+
+                    // a folder that's been loaded before comes straight out of its cache (WavetableCache)
+                    auto waveFiles = WavetableBank::findFrameFiles(file);
+                    auto cacheFile = WavetableCache::getCacheFile(file);
+                    auto sourceHash = WavetableCache::hashSources(file, waveFiles);
+                    auto cached = WavetableCache::read(cacheFile, sourceHash);
+
+                    if (! cached.empty())
+                    {
+                        items.push_back([cached] { return cached; });
+                        continue;
+                    }
+
+                    for (auto& waveFile : waveFiles)
+                        items.push_back(decodeFile(waveFile));
+
+                    request.cacheFile = cacheFile;
+                    request.cacheHash = sourceHash;
+                    request.numCacheItems = (int)items.size();
+                }
+                else if (file.hasFileExtension(".wav"))
+                {
+                    items.push_back(decodeFile(file));
+                }
+            }
+
+            return items;
+        });
+    }
+
+    // single cycles of any length, each resampled to one table on the end
+    void loadCycles(const std::vector<AudioBuffer<float>>& cycles, int oscNum)
+    {
+        std::vector<Decode> items;
+
+        for (auto& cycle : cycles)
+        {
+            items.push_back([cycle]() mutable
+            {
+                return Frames { WavetableBank::createFrame(cycle) };
+            });
+        }
+
+        addRequest(oscNum, false, {}, [items](Request&) { return items; });
+    }
+
+    // a recording cut into cycles (WavetableParser), on the end
+    void loadSlices(const File& file, int oscNum)
+    {
+        addRequest(oscNum, false, file.getFileNameWithoutExtension(), [this, file](Request&)
+        {
+            std::vector<Decode> items;
+            items.push_back([this, file]
+            {
+                Frames frames;
+                std::unique_ptr<AudioFormatReader> reader { formatManager.createReaderFor(file) };
+
+                if (reader != nullptr)
+                {
+                    WavetableParser parser;
+                    for (auto& cycle : parser.parse(*reader))
+                        frames.push_back(WavetableBank::createFrame(cycle));
+                }
 
-private: 
-    //AudioFormatManager formatManager;
+                return frames;
+            });
+
+            return items;
+        });
+    }
+
+    void clear(int oscNum)
+    {
+        addRequest(oscNum, true, {}, [](Request&) { return std::vector<Decode>(); });
+    }
+
+    // drops everything queued for the oscillator that hasn't been published yet
+    void cancel(int oscNum)
+    {
+        const ScopedLock sl(lock);
+
+        for (auto* request : queue)
+            request->oscMask &= ~getMask(oscNum);
+    }
+
+    //==============================================================================
+    // any thread but the audio one
+
+    // blocks until every request so far has been published or dropped
+    void waitUntilIdle()
+    {
+        while (! isIdle())
+            idle.wait(20);
+    }
+
+    bool isIdle() const
+    {
+        const ScopedLock sl(lock);
+        return queue.isEmpty();
+    }
+
+    Status getStatus(int oscNum) const
+    {
+        const ScopedLock sl(lock);
+        Status status;
+        int numItems = 0, numDone = 0;
+
+        for (auto* request : queue)
+        {
+            if ((request->oscMask & getMask(oscNum)) == 0)
+                continue;
+
+            if (! status.isLoading)
+                status.name = request->name;
+
+            status.isLoading = true;
+            numItems += jmax(1, request->numItems.load()); // still being listed counts as one
+            numDone += request->numDone;
+        }
+
+        status.progress = numItems > 0 ? (float)numDone / (float)numItems : 0.f;
+        return status;
+    }
+
+    // the last bank published for an oscillator
+    WavetableBank::Ptr getBank(int oscNum) const
+    {
+        const ScopedLock sl(lock);
+        auto bank = banks[oscNum == 2 ? 1 : 0];
+        return bank != nullptr ? bank : WavetableBank::createEmpty();
+    }
+
+private:
+    using Decode = std::function<Frames()>;
+
+    struct Request : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<Request>;
+
+        std::atomic<int> oscMask { 0 };     // the oscillators it still goes to, 0 once it's cancelled
+        bool replaces = false;              // starts from an empty bank rather than the oscillator's last one
+        String name;
+
+        std::function<std::vector<Decode>(Request&)> listItems; // runs first, on a worker (it can touch the disk)
+        std::vector<Decode> items;
+        std::vector<Frames> results;        // one per item, in item order
+
+        // a folder that wasn't cached yet, its frames (the first numCacheItems) get written out once they're decoded
+        File cacheFile;
+        uint64 cacheHash = 0;
+        int numCacheItems = 0;
+
+        std::atomic<int> numItems { -1 }, nextItem { 0 }, numDone { 0 }, tasksLeft { 0 };
+        std::atomic<bool> isDecoded { false };
+
+        bool isCancelled() const
+        {
+            return oscMask == 0;
+        }
+    };
+
+    PublishBank publish;
+    AudioFormatManager formatManager; // only read once the constructor's done, the workers share it
+
+    CriticalSection lock; // everything below, never the audio thread
+    ReferenceCountedArray<Request> queue;
+    std::array<WavetableBank::Ptr, 2> banks;
+    WaitableEvent idle;
+
+    int numWorkers = 1;
+    ThreadPool pool; // last, so it's gone before anything its jobs use
+
+    static int getMask(int oscNum)
+    {
+        return oscNum == 1 ? 1 : oscNum == 2 ? 2 : 3;
+    }
+
+    Decode decodeFile(const File& file)
+    {
+        return [this, file]
+        {
+            return Frames { WavetableBank::readFrame(file, formatManager) };
+        };
+    }
+
+    void addRequest(int oscNum, bool replaces, const String& name, std::function<std::vector<Decode>(Request&)> listItems)
+    {
+        if (replaces)
+            cancel(oscNum);
+
+        Request::Ptr request = new Request();
+        request->oscMask = getMask(oscNum);
+        request->replaces = replaces;
+        request->name = name;
+        request->listItems = std::move(listItems);
+
+        {
+            const ScopedLock sl(lock);
+            queue.add(request);
+        }
+
+        pool.addJob([this, request] { startRequest(request); });
+    }
+
+    // lists the request's items, then spreads them over as many workers as there are items
+    void startRequest(Request::Ptr request)
+    {
+        if (! request->isCancelled())
+            request->items = request->listItems(*request);
+
+        auto numItems = request->isCancelled() ? 0 : (int)request->items.size();
+        request->results.resize((size_t)numItems);
+
+        auto numTasks = jmin(numWorkers, jmax(1, numItems));
+        request->tasksLeft = numTasks;
+        request->numItems = numItems;
+
+        for (int i = 1; i < numTasks; ++i)
+            pool.addJob([this, request] { decodeItems(request); });
+
+        decodeItems(request);
+    }
+
+    void decodeItems(Request::Ptr request)
+    {
+        for (;;)
+        {
+            if (request->isCancelled())
+                break;
+
+            auto item = request->nextItem++;
+            if (item >= request->numItems)
+                break;
+
+            request->results[(size_t)item] = request->items[(size_t)item]();
+            ++request->numDone;
+        }
+
+        if (--request->tasksLeft == 0)
+        {
+            if (request->cacheFile != File() && ! request->isCancelled())
+                writeCache(*request);
+
+            request->isDecoded = true;
+            publishFinished();
+        }
+    }
+
+    // next time the folder is one mapped file. A cache that can't be written just means decoding it again
+    static void writeCache(const Request& request)
+    {
+        Frames frames;
+        for (int i = 0; i < request.numCacheItems; ++i)
+            frames.insert(frames.end(), request.results[(size_t)i].begin(), request.results[(size_t)i].end());
+
+        WavetableCache::write(request.cacheFile, request.cacheHash, frames);
+    }
+
+    /*
+        Publishes every decoded request that nothing older is still holding up. A request only waits on older ones
+        for the same oscillator, a folder loading on one doesn't hold up the other
+    */
+    void publishFinished()
+    {
+        const ScopedLock sl(lock);
+        int waiting = 0; // oscillators with an older request still decoding
+
+        for (int i = 0; i < queue.size();)
+        {
+            auto* request = queue.getObjectPointerUnchecked(i);
+            auto mask = request->oscMask.load();
+
+            if (! request->isDecoded || (mask & waiting) != 0)
+            {
+                waiting |= mask;
+                ++i;
+                continue;
+            }
+
+            Frames frames;
+            for (auto& result : request->results)
+                frames.insert(frames.end(), result.begin(), result.end());
+
+            for (int osc = 1; osc <= 2; ++osc)
+            {
+                if ((mask & getMask(osc)) == 0)
+                    continue;
+
+                auto& bank = banks[(size_t)osc - 1];
+                auto start = request->replaces || bank == nullptr ? WavetableBank::createEmpty() : bank;
+
+                bank = start->withFrames(frames);
+                publish(osc, bank);
+            }
+
+            queue.remove(i);
+        }
+
+        if (queue.isEmpty())
+            idle.signal();
+    }
 
-};
\ No newline at end of file
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveTableLoader)
+};
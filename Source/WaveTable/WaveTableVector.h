@@ -10,137 +10,241 @@
 
 #pragma once
 #include <JuceHeader.h>
-#include "WaveTable.h"
+#include "WavetableBank.h"
 
 
+/*
+    One oscillator's way through a WavetableBank: the phase, the wave position and its smoothing. The tables
+    themselves live in the bank, which every voice shares, so a vector is only a few floats and a pointer.
+
+    In the synth the vector doesn't own its bank, GaySynth's BankSwap does and moves every voice over to a new one
+    at a block boundary with startFade(). For a short while after that the vector reads both banks and crossfades
+    from the old one to the new one, so a table change in the middle of a note doesn't click.
+*/
 class WaveTableVector
 {
 public:
-    WaveTableVector() : tableSize(2048)
+    WaveTableVector() : tableSize(WavetableBank::tableSize)
     {
-        formatManager.registerBasicFormats();
-
-        // intitialize 100, then just change their waveform 
-        // we keep track of arraySize so that we can map our 0-1 wave value to map to an appropriate value
-        // Wasn't working to clear the array each time
-        for (int i = 0; i < 100; i++)
-        {
-            tableArray.add(new WaveTable(tableSize));
-        }
-        //auto filePath = String("D:/WaveTables/Echo Sound Works Core Tables/FM/");
-        //loadTables("C:/ProgramData/Recluse-Audio/Wavetables/Echo Sound Works Modular/");
-        loadTables("C:/ProgramData/Recluse-Audio/GPC/Wavetables/Vector 1");
+        startFade(nullptr, 0);
     }
 
-    ~WaveTableVector() 
-    {
-        tableArray.clear(true);
-    }
+    ~WaveTableVector() {}
 
     void prepare(double sampleRate)
     {
         mSampleRate = sampleRate;
-        prepTables();
+        phaseScale = (float)((double)tableSize / sampleRate);
         waveVal.reset(sampleRate, 0.01);
     }
 
-    void prepTables()
+    /*
+        Audio thread (GaySynth::beginBlock, under the voice lock). Plays next from now on, fading out of what was
+        playing over numFadeSamples. nullptr or an empty bank plays a sine. Whoever calls this keeps both banks
+        alive until finishFade()
+    */
+    void startFade(const WavetableBank* next, int numFadeSamples)
     {
-        for (int i = 0; i < tableArray.size(); i++)
-        {
-            tableArray[i]->prepare(mSampleRate);
-        }
-        loading = false;
+        auto* target = next != nullptr && next->getNumTables() > 0 ? next : sineBank->bank.get();
+        auto* leaving = playing;
+
+        playing = target;
+        previous = numFadeSamples > 0 && leaving != nullptr && leaving != target ? leaving : nullptr;
+        fadeLeft = previous != nullptr ? numFadeSamples : 0;
+        fadeLength = fadeLeft;
+
+        // the wave position is smoothed in table indices, keep it at the same place in the new bank
+        auto oldLast = leaving != nullptr ? (float)(leaving->getNumTables() - 1) : 0.f;
+        auto newLast = (float)(playing->getNumTables() - 1);
+        auto rescale = oldLast > 0.f ? newLast / oldLast : 0.f;
+
+        previousScale = newLast > 0.f ? oldLast / newLast : 0.f;
+        waveVal.setCurrentAndTargetValue(waveVal.getCurrentValue() * rescale);
+        laneState.wavePos *= rescale;
+        laneState.waveTarget *= rescale;
+        laneState.waveStep *= rescale;
+
+        arraySize = playing->getNumTables();
+    }
+
+    // audio thread, the bank it was fading out of is about to go
+    void finishFade()
+    {
+        previous = nullptr;
+        fadeLeft = 0;
+    }
+
+    bool isFading() const
+    {
+        return fadeLeft > 0;
+    }
 
+    // same bank, same point in the fade (a new voice picking up where voice 0 is). Under the voice lock
+    void copyTablesFrom(WaveTableVector& other)
+    {
+        playing = other.playing;
+        previous = other.previous;
+        fadeLeft = other.fadeLeft;
+        fadeLength = other.fadeLength;
+        previousScale = other.previousScale;
+        arraySize = other.arraySize;
     }
 
     /*
-        Loading files into table array
-        Notice that we are tracking arraySize separately because deleting/clearing the array each time was not working for me
-        if the file path leads to a directory (user dragged on a folder of tables) then we rewrite the existing wave at those
-        indices of the table array
+        For a vector on its own (the micro benchmarks): it owns the bank here and switches straight over.
+        The shortcuts build a new bank from this one's, a folder replaces the tables, a single .wav goes on the end.
+        Not while anything else could be reading the vector
     */
+    void setBank(WavetableBank::Ptr newBank)
+    {
+        ownedBank = newBank != nullptr ? newBank : WavetableBank::createEmpty();
+        startFade(ownedBank.get(), 0);
+    }
+
+    WavetableBank::Ptr getBank() const
+    {
+        return ownedBank != nullptr ? ownedBank : WavetableBank::createEmpty();
+    }
+
     void loadTables(StringRef filePath)
     {
-        loading = true;
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        setBank(WavetableBank::load(File(filePath), getBank(), formatManager));
+    }
 
-        auto waveFile = File(filePath);
+    void clearTables()
+    {
+        setBank(WavetableBank::createEmpty());
+    }
 
-        if (waveFile.isDirectory())
-        {
-            auto waveFolders = waveFile.findChildFiles(2, true, "*.wav");
+    void loadTableFromBuffer(AudioBuffer<float>& waveBuffer)
+    {
+        setBank(getBank()->withFrame(WavetableBank::createFrame(waveBuffer)));
+    }
 
-            arraySize = waveFolders.size() - 1;
+    /*
+        The vector plays on one phase, the tables are just data it reads at that phase. A pitch change is one multiply
+        whatever's loaded, and morphing across the wave position never lands on a table that's drifted off somewhere else
+    */
+    void setFrequency(float freq)
+    {
+        phaseDelta = freq * phaseScale;
+    }
 
-            for (int i = 0; i < arraySize; i++)
-            {
-                auto waveIter = File(waveFolders[i].getFullPathName());
-                std::unique_ptr<AudioFormatReader> formatReader{ formatManager.createReaderFor(waveIter) };
+    // how the tables get read between samples (TableInterpolation), anything reading the vector picks it up per block
+    void setInterpolation(TableInterpolation::Kernel kernel)
+    {
+        interpolation = kernel;
+    }
 
-                formatReader->read(&tableArray[i]->getBuffer(), 0, tableSize, 0, true, false);
-            }
-        }
-        else
-        {
-            if (waveFile.hasFileExtension(".wav"))
-            {    
-                arraySize++; // accounting for added table
-                std::unique_ptr<AudioFormatReader> formatReader{ formatManager.createReaderFor(waveFile) };
-                formatReader->read(&tableArray[arraySize-1]->getBuffer(), 0, tableSize, 0, true, false);
-            }
-        }
-        
+    TableInterpolation::Kernel getInterpolation() const
+    {
+        return interpolation;
+    }
 
-        prepTables();
+    // a sample with the vector's own kernel, a loop that dispatched once already calls getNextSample<Kernel>()
+    float getNextSample()
+    {
+        auto sample = 0.f;
+        TableInterpolation::dispatch(interpolation, [&](auto kernel) { sample = getNextSample<decltype(kernel)>(); });
+        return sample;
     }
 
-    void loadTableFromBuffer(AudioBuffer<float>& waveBuffer)
+    template <typename Kernel>
+    float getNextSample()
     {
-        arraySize++;
-        tableArray[arraySize - 1]->passBuffer(waveBuffer);
+        return readTables<Kernel>(waveVal.getNextValue());
     }
 
-    void setFrequency(float freq)
+    // block version of setWave() + setFrequency() + getNextSample(), one sample at a time because the phase depends on the last sample
+    void renderNextBlock(float* dest, const float* wavePositions, const float* frequencies, int numSamples)
     {
-        for (int i = 0; i < arraySize; i++)
+        TableInterpolation::dispatch(interpolation, [&](auto kernel)
         {
-            tableArray[i]->setFrequency(freq);
-        }
+            using Kernel = decltype(kernel);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                setWave(wavePositions[i]);
+                setFrequency(frequencies[i]);
+                dest[i] = readTables<Kernel>(waveVal.getNextValue());
+            }
+        });
     }
 
-    
-    float getNextSample()
+    /*
+        One step of the wave position for something that reads the tables itself (UnisonStack): smooths towards
+        wavePosition the same way renderNextBlock() does and hands back the two tables either side of it and how
+        far between them it is. Both come at the mip level for mipLevel (WaveTable::getMipLevel), no fade between levels
+    */
+    void getNextFrame(float wavePosition, int mipLevel, WaveTable::Mip& lower, WaveTable::Mip& upper, float& interp)
     {
-        float wavePos = waveVal.getNextValue();
+        setWave(wavePosition);
+        frameWavePos = waveVal.getNextValue();
+        getFrame(*playing, frameWavePos, mipLevel, lower, upper, interp);
+    }
 
-        int lowerWaveIndex = (int)wavePos;
-        int upperWaveIndex = lowerWaveIndex + 1;
+    /*
+        The same for the bank a crossfade is leaving, straight after getNextFrame(). Returns how much of it to mix in
+        and moves the fade on a sample, 0 when there's no fade (and the frames are left alone)
+    */
+    float getFadeFrame(int mipLevel, WaveTable::Mip& lower, WaveTable::Mip& upper, float& interp)
+    {
+        if (fadeLeft <= 0)
+            return 0.f;
 
-        if (lowerWaveIndex + 1 > arraySize - 1)
-        {
-            upperWaveIndex = 0;
-        }
+        getFrame(*previous, frameWavePos * previousScale, mipLevel, lower, upper, interp);
+        return (float)fadeLeft-- / (float)fadeLength;
+    }
 
-        float interp = wavePos - (float)lowerWaveIndex;
+    /*
+        State for the lane engine (VoiceLanes). Lanes carry on from the vector's phase (getPhase / setPhase) but
+        smooth the wave position themselves (same linear ramp as waveVal)
+    */
+    struct LaneState
+    {
+        float wavePos = 0.f, waveTarget = 0.f, waveStep = 0.f;
+        int waveCountdown = 0;
+    };
 
-        auto sample1 = tableArray[lowerWaveIndex]->getNextSample() * (1.f - interp);
+    LaneState& getLaneState()
+    {
+        return laneState;
+    }
 
-        auto sample2 = tableArray[upperWaveIndex]->getNextSample() * (interp);
+    // the lanes and renderNextBlock() smooth the wave position separately, these hand it over when an oscillator moves between them
+    void syncWaveFromLanes()
+    {
+        waveVal.setCurrentAndTargetValue(laneState.wavePos);
+    }
 
-        auto sample = sample1 + sample2;
+    void syncLanesFromWave()
+    {
+        laneState.wavePos = laneState.waveTarget = waveVal.getCurrentValue();
+        laneState.waveStep = 0.f;
+        laneState.waveCountdown = 0;
+    }
 
-        return sample;
+    float getPhase() const
+    {
+        return phase;
+    }
 
-        
+    void setPhase(float newPhase)
+    {
+        phase = newPhase;
     }
 
-    WaveTable& getInterpolatedTable()
+    const WaveTable& getTable(int index) const
     {
-        // TO DO: This is not satisfactory
-        auto table = *tableArray[0];
-        return table;
+        return playing->getTable(index);
     }
 
+    double getSampleRate() const
+    {
+        return mSampleRate;
+    }
 
     void setWave(float waveForm)
     {
@@ -148,29 +252,31 @@ public:
         waveVal.setTargetValue(mappedWaveIndex);
     }
 
-    WaveTable* atIndex(int index)
+    const WaveTable* atIndex(int index) const
     {
-        return tableArray[index];
+        return &playing->getTable(jlimit(0, arraySize - 1, index));
     }
 
+    // the most tables a bank holds
     int vectorSize()
     {
-        return tableArray.size();
+        return WavetableBank::maxTables;
     }
 
+    // a bank is only handed over once it's completely built
     bool isFinishedLoading()
     {
-        return !loading.get();
+        return true;
     }
 
-    WaveTable* getLowerWave(int lowerWaveIndex)
+    const WaveTable* getLowerWave(int lowerWaveIndex) const
     {
-        return tableArray[lowerWaveIndex];
+        return atIndex(lowerWaveIndex);
     }
 
-    WaveTable* getUpperWave(int upperWaveIndex)
+    const WaveTable* getUpperWave(int upperWaveIndex) const
     {
-        return tableArray[upperWaveIndex];
+        return atIndex(upperWaveIndex);
     }
 
     float getWaveVal()
@@ -188,18 +294,88 @@ public:
         return arraySize;
     }
 private:
+    // one sine for every vector that has nothing loaded
+    struct SineBank
+    {
+        WavetableBank::Ptr bank = WavetableBank::createSine();
+    };
 
-    OwnedArray<WaveTable> tableArray;
-    AudioFormatManager formatManager;
-    CriticalSection lock;
+    SharedResourcePointer<SineBank> sineBank;
+    LaneState laneState;
 
     int tableSize = 0;
     int arraySize = 0;
 
     SmoothedValue<float> waveVal; // float interpVal{ 0.f };
+    TableInterpolation::Kernel interpolation = TableInterpolation::Kernel::linear;
+
+    // over the full table size, same as WaveTable's own phase
+    float phase = 0.f, phaseDelta = 0.f;
+    float phaseScale = (float)(2048.0 / 48000.0);
+    float mipDelta = -1.f, mipFade = 0.f; // the mip level is only worked out again when the frequency changes
+    int mipLevel = 0;
+
+    // the bank playing, and the one being faded out of (nullptr when there's no fade). Neither is ever empty
+    const WavetableBank* playing = nullptr;
+    const WavetableBank* previous = nullptr;
+    int fadeLeft = 0, fadeLength = 0;
+    float previousScale = 0.f;  // a wave position in playing -> the same place in previous
+    float frameWavePos = 0.f;   // getNextFrame() -> getFadeFrame()
+
+    WavetableBank::Ptr ownedBank; // only when it's used on its own, see setBank()
+
+    // both banks at the shared phase, then one step on
+    template <typename Kernel>
+    float readTables(float wavePos)
+    {
+        if (phaseDelta != mipDelta)
+        {
+            mipDelta = phaseDelta;
+            mipLevel = WaveTable::getMipLevel(phaseDelta, mipFade);
+        }
+
+        auto sample = readBank<Kernel>(*playing, wavePos);
+
+        if (fadeLeft > 0)
+        {
+            auto gain = (float)fadeLeft-- / (float)fadeLength;
+            sample += gain * (readBank<Kernel>(*previous, wavePos * previousScale) - sample);
+        }
 
+        phase += phaseDelta;
+        phase = phase >= (float)tableSize ? phase - (float)tableSize : phase;
+
+        return sample;
+    }
+
+    template <typename Kernel>
+    float readBank(const WavetableBank& bank, float wavePos) const
+    {
+        int lowerWaveIndex = (int)wavePos;
+        int upperWaveIndex = lowerWaveIndex + 1;
+
+        if (lowerWaveIndex + 1 > bank.getNumTables() - 1)
+        {
+            upperWaveIndex = 0;
+        }
+
+        float interp = wavePos - (float)lowerWaveIndex;
+
+        auto sample1 = bank.getTable(lowerWaveIndex).read<Kernel>(phase, mipLevel, mipFade) * (1.f - interp);
+        auto sample2 = bank.getTable(upperWaveIndex).read<Kernel>(phase, mipLevel, mipFade) * interp;
+
+        return sample1 + sample2;
+    }
+
+    static void getFrame(const WavetableBank& bank, float wavePos, int mipLevel, WaveTable::Mip& lower, WaveTable::Mip& upper, float& interp)
+    {
+        int lowerWaveIndex = (int)wavePos;
+        int upperWaveIndex = lowerWaveIndex + 1 > bank.getNumTables() - 1 ? 0 : lowerWaveIndex + 1;
+
+        interp = wavePos - (float)lowerWaveIndex;
+        lower = bank.getTable(lowerWaveIndex).getMip(mipLevel);
+        upper = bank.getTable(upperWaveIndex).getMip(mipLevel);
+    }
 
-    Atomic<bool> loading { false };
-    
     double mSampleRate = 48000;
 };
\ No newline at end of file
@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    WavetableBank.h
+    Created: 17 Oct 2026 11:32:08pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "WaveTable.h"
+
+/*
+    The frames an oscillator morphs through, with their mip levels. Nothing changes a bank once it's built, so every
+    voice's oscillator points at the same one and only keeps its own phase / wave position (WaveTableVector).
+
+    Changing the tables means building a new bank and publishing it to the voices (GaySynth::publishBank). The
+    functions that make a bank from another one share the frames they keep rather than copying them, a frame is only
+    ever read from disk and FFT'd once. Building never happens on the audio thread (it allocates and reads files).
+*/
+class WavetableBank : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<WavetableBank>;
+
+    static constexpr int tableSize = 2048;
+    static constexpr int maxTables = 256;
+    static constexpr int maxCycleLength = tableSize * 4; // the longest .wav that's still taken as one cycle
+
+    // whatever a frame's samples live in when they aren't its own (WavetableCache maps them straight off disk)
+    struct Storage : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<Storage>;
+
+        virtual ~Storage() = default;
+    };
+
+    // one frame's samples and mip levels, read only once it's in a bank
+    struct Frame : public ReferenceCountedObject
+    {
+        using Ptr = ReferenceCountedObjectPtr<Frame>;
+
+        Frame() {}
+
+        // samples and levels laid out like WaveTable's own, inside storage
+        Frame(const float* samples, const float* levels, Storage::Ptr storageToKeep)
+            : table(samples, levels, tableSize), storage(std::move(storageToKeep))
+        {
+        }
+
+        WaveTable table { tableSize };
+        Storage::Ptr storage; // keeps what table points into alive, nullptr when it has its own
+    };
+
+    //==============================================================================
+    static Ptr createEmpty()
+    {
+        return new WavetableBank();
+    }
+
+    // what an oscillator plays while it has no tables
+    static Ptr createSine()
+    {
+        Frame::Ptr frame = new Frame();
+        frame->table.createSineTable();
+        frame->table.buildMips();
+
+        return createEmpty()->withFrame(frame);
+    }
+
+    /*
+        A folder becomes a bank of its own (every .wav anywhere under it), a single .wav goes on the end of
+        `current`, that's what dropping one on an oscillator has always done. Anything else gives back `current`.
+        This is the synchronous version, the plugin goes through WaveTableLoader
+    */
+    static Ptr load(const File& file, Ptr current, AudioFormatManager& formatManager)
+    {
+        if (current == nullptr)
+            current = createEmpty();
+
+        if (file.isDirectory())
+        {
+            Ptr bank = createEmpty();
+
+            for (auto& waveFile : findFrameFiles(file))
+            {
+                if (auto frame = readFrame(waveFile, formatManager))
+                    bank->frames.add(frame);
+            }
+
+            return bank;
+        }
+
+        if (file.hasFileExtension(".wav"))
+        {
+            if (auto frame = readFrame(file, formatManager))
+                return current->withFrame(frame);
+        }
+
+        return current;
+    }
+
+    // the .wav files a folder's bank is made of, no more than fit in a bank
+    static Array<File> findFrameFiles(const File& folder)
+    {
+        auto files = folder.findChildFiles(File::findFiles, true, "*.wav");
+        files.removeRange(maxTables, files.size());
+        return files;
+    }
+
+    /*
+        One single cycle .wav, resampled to tableSize if it's any other length up to maxCycleLength. Longer files only
+        have their first tableSize samples read, same as always. Peak normalised. nullptr if it can't be read
+    */
+    static Frame::Ptr readFrame(const File& file, AudioFormatManager& formatManager)
+    {
+        std::unique_ptr<AudioFormatReader> formatReader { formatManager.createReaderFor(file) };
+
+        if (formatReader == nullptr || formatReader->lengthInSamples <= 0)
+            return nullptr;
+
+        Frame::Ptr frame = new Frame();
+        auto& table = frame->table.getBuffer();
+        table.clear();
+
+        if (formatReader->lengthInSamples == tableSize || formatReader->lengthInSamples > maxCycleLength)
+        {
+            formatReader->read(&table, 0, tableSize, 0, true, false);
+        }
+        else
+        {
+            AudioBuffer<float> cycle(1, (int)formatReader->lengthInSamples);
+            formatReader->read(&cycle, 0, cycle.getNumSamples(), 0, true, false);
+            frame->table.passBuffer(cycle);
+        }
+
+        auto peak = table.getMagnitude(0, 0, tableSize);
+        if (peak > 1.0e-5f)
+            table.applyGain(0, 0, tableSize, 1.f / peak);
+
+        frame->table.buildMips();
+        return frame;
+    }
+
+    // a single cycle of any length, resampled to tableSize (WaveTable::passBuffer)
+    static Frame::Ptr createFrame(AudioBuffer<float>& singleCycle)
+    {
+        Frame::Ptr frame = new Frame();
+        frame->table.passBuffer(singleCycle);
+        frame->table.buildMips();
+        return frame;
+    }
+
+    // this bank's frames and one more on the end. A full bank comes back as it is
+    Ptr withFrame(Frame::Ptr frame) const
+    {
+        return withFrames({ frame });
+    }
+
+    // the same for a few at once, nullptrs are skipped and whatever doesn't fit is left off
+    Ptr withFrames(const std::vector<Frame::Ptr>& newFrames) const
+    {
+        Ptr bank = createEmpty();
+        bank->frames.addArray(frames);
+
+        for (auto& frame : newFrames)
+            if (frame != nullptr && bank->getNumTables() < maxTables)
+                bank->frames.add(frame);
+
+        return bank;
+    }
+
+    //==============================================================================
+    int getNumTables() const
+    {
+        return frames.size();
+    }
+
+    const WaveTable& getTable(int index) const
+    {
+        return frames.getObjectPointerUnchecked(index)->table;
+    }
+
+private:
+    WavetableBank()
+    {
+        frames.ensureStorageAllocated(maxTables);
+    }
+
+    ReferenceCountedArray<Frame> frames;
+};
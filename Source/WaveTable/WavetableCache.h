@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    WavetableCache.h
+    Created: 18 Oct 2026 1:14:52am
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "WavetableBank.h"
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+ #include <sys/mman.h>
+#endif
+
+/*
+    A folder's frames already decoded, resampled and band limited, in a .gpcwt file that gets memory mapped and
+    played straight out of. Loading a cached folder is one map and a look at the header, the frames in the bank
+    point into the mapping (WavetableBank::Frame::storage keeps it open).
+
+    Layout, native floats and byte order (byteOrder says which):
+        Header              64 bytes
+        frame 0             the table (tableSize), then every mip level past 0 back to back (WaveTable::getMipStorageSize)
+        frame 1 ...         frameStride bytes apart, a multiple of 64 so every frame and level starts 64 byte aligned
+
+    A cache is only used when everything in the header matches this build, including the hash of the files it
+    was made from (names, sizes, times). Bump version whenever what goes into a frame changes (the decoding,
+    normalising or mip building).
+
+    The audio thread must never be the first to read a page of the mapping, that's a page fault and a disk read in
+    the middle of a block. read() faults every page in (and locks them where the OS lets it) before it returns, so
+    it has to run on the loader thread, ahead of the bank being published.
+*/
+class WavetableCache
+{
+public:
+    using Frames = std::vector<WavetableBank::Frame::Ptr>;
+
+    static constexpr uint32 version = 1;
+
+    struct Header
+    {
+        char magic[8];          // "GPCWT"
+        uint32 version;
+        uint32 byteOrder;       // byteOrderMark as it was written
+        uint32 headerSize;
+        uint32 numFrames;
+        uint32 tableSize;
+        uint32 numMipLevels;
+        uint32 frameStride;     // bytes
+        uint32 reserved0;
+        uint64 sourceHash;
+        uint64 fileSize;
+        uint8 reserved[8];
+    };
+
+    static_assert(sizeof(Header) == 64, "the frames start on the first 64 byte boundary");
+
+    // where a folder's cache goes, one file per folder
+    static File getCacheFile(const File& folder)
+    {
+        return File::getSpecialLocation(File::userApplicationDataDirectory)
+            .getChildFile("Recluse-Audio/GPC/Cache")
+            .getChildFile(File::createLegalFileName(folder.getFileName()) + "_"
+                          + String::toHexString(folder.getFullPathName().hashCode64()) + ".gpcwt");
+    }
+
+    // what the frames were made from, a file that's changed, moved or gone makes the cache stale
+    static uint64 hashSources(const File& folder, const Array<File>& files)
+    {
+        String description;
+
+        for (auto& file : files)
+            description << file.getRelativePathFrom(folder) << ':' << file.getSize() << ':'
+                        << file.getLastModificationTime().toMilliseconds() << '\n';
+
+        return (uint64)description.hashCode64();
+    }
+
+    /*
+        The cached frames, pointing into the mapped file, or nothing if there's no cache for sourceHash (missing,
+        stale, from another build or cut short). Any thread but the audio one, every page is read in before this
+        returns
+    */
+    static Frames read(const File& cacheFile, uint64 sourceHash)
+    {
+        if (! cacheFile.existsAsFile())
+            return {};
+
+        Mapping::Ptr mapping = new Mapping(cacheFile);
+        auto* data = static_cast<const char*>(mapping->file.getData());
+        auto size = (uint64)mapping->file.getSize();
+
+        if (data == nullptr || size < sizeof(Header))
+            return {};
+
+        Header header;
+        std::memcpy(&header, data, sizeof(Header));
+
+        if (! isValid(header, size, sourceHash))
+            return {};
+
+        mapping->faultIn();
+
+        Frames frames;
+        frames.reserve(header.numFrames);
+
+        for (uint32 i = 0; i < header.numFrames; ++i)
+        {
+            auto* samples = reinterpret_cast<const float*>(data + header.headerSize + (size_t)i * header.frameStride);
+            frames.push_back(new WavetableBank::Frame(samples, samples + WavetableBank::tableSize, mapping));
+        }
+
+        return frames;
+    }
+
+    // writes a new cache next to the old one and swaps it in, so nothing ever maps half a file. False if it couldn't
+    static bool write(const File& cacheFile, uint64 sourceHash, const Frames& frames)
+    {
+        Frames toWrite;
+
+        // only frames with their mip levels built have anything to write
+        for (auto& frame : frames)
+            if (frame != nullptr && frame->table.getMip(1).data != frame->table.getBuffer().getReadPointer(0)
+                && (int)toWrite.size() < WavetableBank::maxTables)
+                toWrite.push_back(frame);
+
+        if (toWrite.empty())
+            return false;
+
+        if (! cacheFile.getParentDirectory().createDirectory())
+            return false;
+
+        auto header = makeHeader((uint32)toWrite.size(), sourceHash);
+        TemporaryFile temp(cacheFile);
+
+        {
+            auto out = temp.getFile().createOutputStream();
+
+            if (out == nullptr || ! out->write(&header, sizeof(Header)))
+                return false;
+
+            auto tableBytes = (size_t)WavetableBank::tableSize * sizeof(float);
+            auto levelBytes = (size_t)WaveTable::getMipStorageSize(WavetableBank::tableSize) * sizeof(float);
+
+            for (auto& frame : toWrite)
+            {
+                auto& table = frame->table;
+
+                if (! out->write(table.getBuffer().getReadPointer(0), tableBytes)
+                    || ! out->write(table.getMip(1).data, levelBytes)
+                    || ! out->writeRepeatedByte(0, header.frameStride - tableBytes - levelBytes))
+                    return false;
+            }
+
+            out->flush();
+
+            if (out->getStatus().failed())
+                return false;
+        }
+
+        return temp.overwriteTargetFileWithTemporary();
+    }
+
+private:
+    static constexpr uint32 byteOrderMark = 0x01020304;
+
+    struct Mapping : public WavetableBank::Storage
+    {
+        using Ptr = ReferenceCountedObjectPtr<Mapping>;
+
+        explicit Mapping(const File& f) : file(f, MemoryMappedFile::readOnly) {}
+
+        // asks for the whole file up front, locks it if allowed, then touches a byte a page so it's all resident.
+        // A failed mlock (over RLIMIT_MEMLOCK) only means the pages could be evicted again under memory pressure.
+        // Unmapping drops the lock, nothing to undo
+        void faultIn()
+        {
+            auto* data = static_cast<const char*>(file.getData());
+            auto size = file.getSize();
+
+           #if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+            madvise(const_cast<char*>(data), size, MADV_WILLNEED);
+            mlock(data, size);
+           #endif
+
+            constexpr size_t pageSize = 4096; // the smallest anything uses, bigger pages just get touched more than once
+            volatile char sink = 0;
+
+            for (size_t i = 0; i < size; i += pageSize)
+                sink = sink + data[i];
+
+            sink = sink + data[size - 1];
+        }
+
+        MemoryMappedFile file;
+    };
+
+    static uint32 getFrameStride()
+    {
+        auto bytes = (uint32)((WavetableBank::tableSize + WaveTable::getMipStorageSize(WavetableBank::tableSize)) * sizeof(float));
+        return (bytes + 63u) & ~63u;
+    }
+
+    static Header makeHeader(uint32 numFrames, uint64 sourceHash)
+    {
+        Header header {};
+        std::memcpy(header.magic, "GPCWT\0\0", 8);
+        header.version = version;
+        header.byteOrder = byteOrderMark;
+        header.headerSize = (uint32)sizeof(Header);
+        header.numFrames = numFrames;
+        header.tableSize = (uint32)WavetableBank::tableSize;
+        header.numMipLevels = (uint32)WaveTable::numMipLevels;
+        header.frameStride = getFrameStride();
+        header.sourceHash = sourceHash;
+        header.fileSize = (uint64)header.headerSize + (uint64)numFrames * header.frameStride;
+        return header;
+    }
+
+    // everything but the samples themselves, those are trusted as they were written
+    static bool isValid(const Header& header, uint64 mappedSize, uint64 sourceHash)
+    {
+        auto expected = makeHeader(header.numFrames, sourceHash);
+
+        return std::memcmp(header.magic, expected.magic, 8) == 0
+            && header.version == expected.version
+            && header.byteOrder == expected.byteOrder
+            && header.headerSize == expected.headerSize
+            && header.numFrames > 0 && header.numFrames <= (uint32)WavetableBank::maxTables
+            && header.tableSize == expected.tableSize
+            && header.numMipLevels == expected.numMipLevels
+            && header.frameStride == expected.frameStride
+            && header.sourceHash == expected.sourceHash
+            && header.fileSize == expected.fileSize
+            && mappedSize == expected.fileSize;
+    }
+};
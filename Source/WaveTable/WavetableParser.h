@@ -9,104 +9,70 @@
 */
 
 #pragma once
+#include <JuceHeader.h>
 #include "Yin.h"
-#include "../Processor/PluginProcessor.h"
 
+/*
+    Cuts a recording (anything dropped on a visualizer) into single cycles: finds its pitch with YIN, then takes
+    numWaves chunks of two periods spread evenly through the file. WaveTableLoader runs this on its worker threads,
+    so it only ever touches the file and its own buffers.
+*/
 class WavetableParser
 {
 public:
-    WavetableParser(GayPolyCommunistAudioProcessor& p) : audioProcessor(p)
-    {
-        formatManager.registerBasicFormats();
-        yinObject = std::make_unique<PitchYIN>((int)audioProcessor.getSampleRate(), 48000);
-        waveBuffer.setSize(1, 480000); // one channel, ten seconds
-    }
+    static constexpr int numWaves = 16;     // number of waves to split into
+    static constexpr int yinSize = 48000;   // how much of the file the pitch comes from
 
+    WavetableParser() {}
     ~WavetableParser() {}
 
-    void loadFile(File waveFile)
+    // the whole file, up to ten seconds. Empty if it's silent or has no pitch to find
+    std::vector<AudioBuffer<float>> parse(AudioFormatReader& reader)
     {
-        std::unique_ptr<AudioFormatReader> formatReader{ formatManager.createReaderFor(waveFile) };
-        formatReader->read(&waveBuffer, 0, 480000, 0, true, false); // writes waveFile into our waveBuffer, up to 10 seconds
-        calculatePeriod();
-    }
+        auto length = (int)jmin(reader.lengthInSamples, (int64)(reader.sampleRate * 10.0));
 
-    // parses and then passes wavetable vector to processor/synth/oscillators/wavetablevector/wavetable
-    void loadFileToOsc(File waveFile, int oscNum)
-    {
-        std::unique_ptr<AudioFormatReader> formatReader{ formatManager.createReaderFor(waveFile) };
+        // YIN always reads yinSize samples, a short file is padded out with silence
+        waveBuffer.setSize(1, jmax(length, yinSize));
         waveBuffer.clear();
-        waveBuffer.setSize(1, formatReader->lengthInSamples);
-        formatReader->read(&waveBuffer, 0, formatReader->lengthInSamples - 1, 0, true, false); // writes waveFile into our waveBuffer, up to 10 seconds
-        calculatePeriod();
-
-        // find and load 16 chunks of waves
-        int numWaves = 16; // number of waves to split into
-        int waveChunk = formatReader->lengthInSamples / numWaves; // samples between each 'sampling' of a waveform
-        for (int i = 0; i < numWaves; i++)
-        {
-            int startPos = waveChunk * i;
-            fillSingleCycle(startPos);
-            audioProcessor.loadTableFromBuffer(singleCycle, oscNum);
-        }
-        
-    }
+        reader.read(&waveBuffer, 0, length, 0, true, false);
 
-    void calculatePeriod()
-    {
-        auto buffRead = waveBuffer.getReadPointer(0);
-        auto freq = yinObject->getPitchInHz(buffRead);
-        period = audioProcessor.getSampleRate() / freq;
-    }
+        calculatePeriod(reader.sampleRate);
 
-    void fillSingleCycle(int startPos)
-    {
-        int p = period * 2.f; // getting better results with this instead of just 1 period
-        singleCycle.clear();
-        singleCycle.setSize(1, p);
+        std::vector<AudioBuffer<float>> cycles;
+        auto cycleLength = (int)(period * 2.f); // getting better results with this instead of just 1 period
 
-        auto buffWrite = singleCycle.getArrayOfWritePointers();
-        auto buffRead = waveBuffer.getArrayOfReadPointers();
+        if (cycleLength < 2 || cycleLength > length)
+            return cycles;
 
-        for (int i = 0; i < p; i++)
-        {
-            buffWrite[0][i] = buffRead[0][startPos + i];
-        }
-
-        float gain = 1.f + (1.f - singleCycle.getRMSLevel(0, 0, singleCycle.getNumSamples())); // gain increas if rms decreases
-        singleCycle.applyGain(gain);
-    }
-
-    // replaced by calculate single cycle / probably gonna delete
-    AudioBuffer<float>& getWaveBuffer()
-    {
-        int p = period * 2.f; // getting better results with this instead of just 1 period
-        singleCycle.clear();
-        singleCycle.setSize(1, p);
-
-        auto buffWrite = singleCycle.getArrayOfWritePointers();
-        auto buffRead = waveBuffer.getArrayOfReadPointers();
-
-        int startPos = p * 4; // getting into the 
-
-        for (int i = 0; i < p; i++)
+        int waveChunk = (length - cycleLength) / numWaves; // samples between each 'sampling' of a waveform
+        for (int i = 0; i < numWaves; i++)
         {
-            buffWrite[0][i] = buffRead[0][startPos + i];
+            cycles.push_back(fillSingleCycle(waveChunk * i, cycleLength));
         }
-       
 
-        return singleCycle;
+        return cycles;
     }
 
 private:
-    AudioFormatManager formatManager;
     AudioBuffer<float> waveBuffer; // for pitch analysis and dissection
-    AudioBuffer<float> singleCycle;  // 
 
     float period = 0.f;
-    int tableSize = 2048;
 
-    std::unique_ptr<PitchYIN> yinObject;
+    // the period in the file's own samples
+    void calculatePeriod(double sampleRate)
+    {
+        PitchYIN yin((int)sampleRate, yinSize);
+        auto freq = yin.getPitchInHz(waveBuffer.getReadPointer(0));
+        period = freq > 0.f ? (float)(sampleRate / freq) : 0.f;
+    }
+
+    AudioBuffer<float> fillSingleCycle(int startPos, int cycleLength)
+    {
+        AudioBuffer<float> singleCycle(1, cycleLength);
+        singleCycle.copyFrom(0, 0, waveBuffer, 0, startPos, cycleLength);
 
-    GayPolyCommunistAudioProcessor& audioProcessor;
-};
\ No newline at end of file
+        float gain = 1.f + (1.f - singleCycle.getRMSLevel(0, 0, singleCycle.getNumSamples())); // gain increas if rms decreases
+        singleCycle.applyGain(gain);
+        return singleCycle;
+    }
+};
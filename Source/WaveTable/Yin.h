@@ -123,12 +123,13 @@ public:
         float pitch = 0.0;
         //slideBlock (input);
         pitch = calculatePitch(inputData);
-        log->writeToLog("period: " + String(pitch));
+
+        DBG("period: " + String(pitch));
 
         if (pitch > 0)
         {
             pitch = sampleRate / (pitch + 0.0);
-            log->writeToLog("pitchInHz: " + String(pitch));
+            DBG("pitchInHz: " + String(pitch));
         }
         else
         {
@@ -153,7 +154,6 @@ private:
     unsigned int sampleRate;
     bool deltaWasNegative;
     float currentPitch;
-    Logger* log;
 
     //    /** adapter to stack ibuf new samples at the end of buf, and trim `buf` to `bufsize` */
     //    void slideBlock (AudioSampleBuffer& ibuf)
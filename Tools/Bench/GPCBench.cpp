@@ -0,0 +1,661 @@
+/*
+  ==============================================================================
+
+    GPCBench.cpp
+    Created: 17 Oct 2026 9:58:03am
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <thread>
+#include "Processor/PluginProcessor.h"
+#include "ScriptedMidi.h"
+
+/*
+    Offline render benchmark.
+    Builds the real processor, prepares it, and pushes a scripted MIDI pattern through processBlock as fast
+    as it will go, once per sample rate / block size combination.
+
+    gpc_bench [--seconds=10] [--block-sizes=64,256,1024] [--sample-rates=44100,48000,96000]
+              [--pattern=chords|arp|pad|burst] [--notes=4] [--warmup=1] [--engine=voice|lanes|parallel] [--threads=n]
+
+    --engine=lanes runs the oscillators of all active voices through the simd lane engine (VoiceLanes).
+    --engine=parallel spreads groups of voices over --threads worker threads (VoiceRenderPool), default is one
+    less than the number of physical cores.
+
+    gpc_bench --scaling [--voices=1,2,4,8,16,32,64,128] [--densities=0.5,1,2] [--routings=none,lfo,env,full]
+              [--seconds=2] [--block-sizes=256] [--sample-rates=48000] [--csv=out.csv]
+        Polyphony sweep. For every routing x voice count x density (notes per chord = density * voices, so 2 means
+        half the notes have to steal) it times a render and plots cost per block against active voices, then
+        fits cost ~ voices^k and flags anything that grows faster than linear.
+
+    gpc_bench --rt-check [same options]
+        Needs a -DGPC_RT_SANITIZER=ON build. Renders on its own thread like a host would, automating parameters
+        every few blocks and loading wavetables from the message thread halfway through, then prints every
+        allocation / lock / file access that happened inside processBlock. Exits 1 if there were any.
+
+    gpc_bench --control-rate [--routing=full] [--seconds=2] [--block-sizes=256] [--sample-rates=48000] [--pattern] [--notes]
+        Renders the same pattern at audio rate and then at every control rate (8 / 16 / 32 / 64, linear and cubic),
+        all with the given modulation routing, and prints what each one costs and how far it ends up from the
+        audio rate render (worst sample and error energy relative to the signal, in dB).
+
+    gpc_bench --automation [--interval=64] [--seconds=2] [--block-sizes=64,512,2048] [--sample-rates=48000] [--pattern] [--notes]
+        Sweeps the filter cutoff with a new value every --interval samples and renders it four ways at every block
+        size: no automation, a full update() per change at the block start (the old behaviour), only the changed
+        parameter at the block start (what a host gets) and sample accurate (queueParameterChange). Prints the cost
+        per block and the error energy against the sample accurate render at the smallest block size, in dB.
+*/
+
+namespace
+{
+    struct BenchResult
+    {
+        double sampleRate = 0.0;
+        int blockSize = 0;
+        double realtimeFactor = 0.0;
+        double nsPerSampleVoice = 0.0;
+        double worstBlockUs = 0.0;
+        double worstBlockBudget = 0.0; // worst block as a fraction of the time the block represents
+        double averageVoices = 0.0;
+        double averageBlockUs = 0.0;
+    };
+
+    int numRenderThreads = -1; // --threads, -1 leaves the synth's default
+
+    GaySynth::EngineMode engineFromName(const String& name)
+    {
+        if (name == "lanes")    return GaySynth::EngineMode::lanes;
+        if (name == "parallel") return GaySynth::EngineMode::parallel;
+        return GaySynth::EngineMode::perVoice;
+    }
+
+    int countActiveVoices(GaySynth& synth)
+    {
+        int active = 0;
+        for (int i = 0; i < synth.getNumVoices(); ++i)
+            if (synth.getVoice(i)->isActive())
+                ++active;
+
+        return active;
+    }
+
+    Array<int> parseIntList(const String& list)
+    {
+        Array<int> values;
+        for (auto& token : StringArray::fromTokens(list, ",", ""))
+            if (token.trim().getIntValue() > 0)
+                values.add(token.trim().getIntValue());
+
+        return values;
+    }
+
+    BenchResult runBench(double sampleRate, int blockSize, double seconds, double warmupSeconds,
+                         ScriptedMidi::Pattern pattern, int notesPerChord, GaySynth::EngineMode engine,
+                         std::function<void(GayPolyCommunistAudioProcessor&)> configure = nullptr,
+                         AudioBuffer<float>* capture = nullptr, // gets everything after the warmup, if given
+                         std::function<void(GayPolyCommunistAudioProcessor&, int64, int)> beforeBlock = nullptr) // timed along with the block
+    {
+        auto processor = std::make_unique<GayPolyCommunistAudioProcessor>();
+        processor->getSynth().setEngineMode(engine);
+
+        if (engine == GaySynth::EngineMode::parallel && numRenderThreads >= 0)
+            processor->getSynth().setNumRenderThreads(numRenderThreads);
+
+        if (configure != nullptr)
+            configure(*processor);
+
+        processor->setPlayConfigDetails(0, 2, sampleRate, blockSize);
+        processor->prepareToPlay(sampleRate, blockSize);
+        processor->waitForWaveTables();
+
+        auto warmupSamples = (int64)(warmupSeconds * sampleRate);
+        auto totalSamples = (int64)(seconds * sampleRate);
+
+        ScriptedMidi midiScript(pattern, notesPerChord, sampleRate, warmupSamples + totalSamples);
+
+        AudioBuffer<float> buffer(2, blockSize);
+        MidiBuffer midi;
+        midi.ensureSize(4096);
+
+        BenchResult result;
+        result.sampleRate = sampleRate;
+        result.blockSize = blockSize;
+
+        int64 renderedTicks = 0, worstTicks = 0;
+        double voiceSamples = 0.0;
+        int64 position = 0;
+        int numBlocks = 0;
+
+        while (position < warmupSamples + totalSamples)
+        {
+            auto numSamples = (int)jmin((int64)blockSize, warmupSamples + totalSamples - position);
+            buffer.setSize(2, numSamples, false, false, true);
+            buffer.clear();
+            midiScript.fillBlock(midi, position, numSamples);
+
+            auto start = Time::getHighResolutionTicks();
+
+            if (beforeBlock != nullptr)
+                beforeBlock(*processor, position, numSamples);
+
+            processor->processBlock(buffer, midi);
+            auto elapsed = Time::getHighResolutionTicks() - start;
+
+            if (position >= warmupSamples)
+            {
+                if (capture != nullptr)
+                    for (int ch = 0; ch < capture->getNumChannels(); ++ch)
+                        capture->copyFrom(ch, (int)(position - warmupSamples), buffer, ch, 0, numSamples);
+
+                renderedTicks += elapsed;
+                worstTicks = jmax(worstTicks, elapsed);
+                voiceSamples += (double)countActiveVoices(processor->getSynth()) * numSamples;
+                ++numBlocks;
+            }
+
+            position += numSamples;
+        }
+
+        auto renderedSeconds = Time::highResolutionTicksToSeconds(renderedTicks);
+        auto worstSeconds = Time::highResolutionTicksToSeconds(worstTicks);
+
+        result.realtimeFactor = renderedSeconds > 0.0 ? seconds / renderedSeconds : 0.0;
+        result.nsPerSampleVoice = voiceSamples > 0.0 ? renderedSeconds * 1.0e9 / voiceSamples : 0.0;
+        result.worstBlockUs = worstSeconds * 1.0e6;
+        result.worstBlockBudget = worstSeconds / ((double)blockSize / sampleRate);
+        result.averageVoices = numBlocks > 0 ? voiceSamples / (seconds * sampleRate) : 0.0;
+        result.averageBlockUs = numBlocks > 0 ? renderedSeconds * 1.0e6 / numBlocks : 0.0;
+
+        processor->releaseResources();
+        return result;
+    }
+
+    //==============================================================================
+    // polyphony sweep
+    struct ScalingPoint
+    {
+        String routing;
+        int voices = 0, notes = 0;
+        double density = 0.0;
+        BenchResult result;
+    };
+
+    // anything that isn't "none" routes every modulator slot of that kind, cycling through the three sources
+    void applyRouting(GayPolyCommunistAudioProcessor& processor, const String& routing)
+    {
+        auto routeLFOs = routing == "lfo" || routing == "full";
+        auto routeEnvs = routing == "env" || routing == "full";
+        int lfoSource = 0, envSource = 0;
+
+        for (auto* p : processor.getParameters())
+        {
+            auto* param = dynamic_cast<RangedAudioParameter*>(p);
+            if (param == nullptr)
+                continue;
+
+            float source = -1.f;
+            if (param->paramID.contains("LFO Source"))
+                source = routeLFOs ? (float)(lfoSource++ % 3 + 1) : 0.f;
+            else if (param->paramID.contains("Env Source"))
+                source = routeEnvs ? (float)(envSource++ % 3 + 1) : 0.f;
+
+            if (source >= 0.f)
+                param->setValueNotifyingHost(param->convertTo0to1(source));
+        }
+    }
+
+    // least squares slope of log(cost) against log(active voices), 1 = linear
+    double scalingExponent(const std::vector<ScalingPoint>& points)
+    {
+        double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+        int n = 0;
+
+        for (auto& p : points)
+        {
+            if (p.result.averageVoices < 1.0 || p.result.averageBlockUs <= 0.0)
+                continue;
+
+            auto x = std::log(p.result.averageVoices);
+            auto y = std::log(p.result.averageBlockUs);
+            sx += x; sy += y; sxx += x * x; sxy += x * y;
+            ++n;
+        }
+
+        auto denominator = n * sxx - sx * sx;
+        return (n < 2 || denominator <= 0.0) ? 0.0 : (n * sxy - sx * sy) / denominator;
+    }
+
+    void plotScaling(const std::vector<ScalingPoint>& points)
+    {
+        const int width = 60;
+        double maxUs = 0.0;
+        for (auto& p : points)
+            maxUs = jmax(maxUs, p.result.averageBlockUs);
+
+        for (auto& p : points)
+        {
+            auto bar = maxUs > 0.0 ? roundToInt(p.result.averageBlockUs / maxUs * width) : 0;
+            std::cout << String::formatted("  %6.1f voices |%-*s %.1fus", p.result.averageVoices, width,
+                                           String::repeatedString("#", bar).toRawUTF8(), p.result.averageBlockUs) << std::endl;
+        }
+    }
+
+    int runScaling(const ArgumentList& args, double sampleRate, int blockSize, double seconds, double warmup, GaySynth::EngineMode engine)
+    {
+        auto voiceCounts = parseIntList(args.containsOption("--voices") ? args.getValueForOption("--voices") : "1,2,4,8,16,32,64,128");
+        auto densities = StringArray::fromTokens(args.containsOption("--densities") ? args.getValueForOption("--densities") : "0.5,1,2", ",", "");
+        auto routings = StringArray::fromTokens(args.containsOption("--routings") ? args.getValueForOption("--routings") : "none,lfo,env,full", ",", "");
+
+        std::vector<ScalingPoint> points;
+
+        std::cout << String::formatted("%-6s %6s %7s %6s %8s %12s %14s %10s",
+                                       "route", "voices", "density", "notes", "active", "us/block", "ns/smp/voice", "rt-factor") << std::endl;
+
+        for (auto& routing : routings)
+        {
+            for (auto voices : voiceCounts)
+            {
+                for (auto& densityText : densities)
+                {
+                    ScalingPoint point;
+                    point.routing = routing.trim();
+                    point.voices = voices;
+                    point.density = densityText.getDoubleValue();
+                    point.notes = jlimit(1, 128, roundToInt(point.density * voices));
+
+                    point.result = runBench(sampleRate, blockSize, seconds, warmup, ScriptedMidi::chords, point.notes, engine,
+                                            [&](GayPolyCommunistAudioProcessor& p)
+                                            {
+                                                p.setPolyphony(voices);
+                                                applyRouting(p, point.routing);
+                                            });
+
+                    std::cout << String::formatted("%-6s %6d %7.2f %6d %8.2f %12.2f %14.2f %10.2f",
+                                                   point.routing.toRawUTF8(), voices, point.density, point.notes,
+                                                   point.result.averageVoices, point.result.averageBlockUs,
+                                                   point.result.nsPerSampleVoice, point.result.realtimeFactor) << std::endl;
+                    points.push_back(point);
+                }
+            }
+        }
+
+        //==============================================================================
+        std::cout << std::endl << "cost per block against active voices (" << blockSize << " samples)" << std::endl;
+
+        int superLinear = 0;
+        for (auto& routing : routings)
+        {
+            std::vector<ScalingPoint> routed;
+            for (auto& p : points)
+                if (p.routing == routing.trim())
+                    routed.push_back(p);
+
+            std::sort(routed.begin(), routed.end(), [](const ScalingPoint& a, const ScalingPoint& b)
+            {
+                return a.result.averageVoices < b.result.averageVoices;
+            });
+
+            // a little slack for cache effects, past that each extra voice is costing more than the last one
+            auto exponent = scalingExponent(routed);
+            auto flagged = exponent > 1.15;
+            superLinear += flagged ? 1 : 0;
+
+            std::cout << std::endl << routing.trim() << ": cost ~ voices^" << String(exponent, 2)
+                      << (flagged ? "  <-- SUPER-LINEAR" : "") << std::endl;
+            plotScaling(routed);
+        }
+
+        if (args.containsOption("--csv"))
+        {
+            auto csvFile = args.getFileForOption("--csv");
+            String csv = "routing,voices,density,notes,active_voices,us_per_block,ns_per_sample_voice,realtime_factor\n";
+
+            for (auto& p : points)
+                csv << p.routing << "," << p.voices << "," << p.density << "," << p.notes << ","
+                    << p.result.averageVoices << "," << p.result.averageBlockUs << ","
+                    << p.result.nsPerSampleVoice << "," << p.result.realtimeFactor << "\n";
+
+            if (! csvFile.replaceWithText(csv))
+                std::cerr << "couldn't write " << csvFile.getFullPathName() << std::endl;
+        }
+
+        return superLinear > 0 ? 1 : 0;
+    }
+
+    //==============================================================================
+    // control rate quality / cost
+    void setChoice(GayPolyCommunistAudioProcessor& processor, const String& paramID, int choice)
+    {
+        if (auto* param = processor.getValueTree().getParameter(paramID))
+            param->setValueNotifyingHost(param->convertTo0to1((float)choice));
+    }
+
+    int runControlRate(const ArgumentList& args, double sampleRate, int blockSize, double seconds, double warmup,
+                       ScriptedMidi::Pattern pattern, int notesPerChord, GaySynth::EngineMode engine)
+    {
+        auto routing = args.containsOption("--routing") ? args.getValueForOption("--routing") : String("full");
+        auto numSamples = (int)(seconds * sampleRate);
+
+        struct Mode
+        {
+            int choice;
+            ControlTicks::Interpolation interpolation;
+        };
+
+        Array<Mode> modes { { 0, ControlTicks::linear } };
+        for (int choice = 1; choice < ControlTicks::getChoices().size(); ++choice)
+        {
+            modes.add({ choice, ControlTicks::linear });
+            modes.add({ choice, ControlTicks::cubic });
+        }
+
+        AudioBuffer<float> reference(2, numSamples), rendered(2, numSamples);
+        double referenceUs = 0.0, referenceEnergy = 0.0;
+
+        std::cout << String::formatted("%-8s %-7s %12s %10s %9s %12s %14s",
+                                       "rate", "interp", "us/block", "rt-factor", "speedup", "max error", "error (dB)") << std::endl;
+
+        for (auto& mode : modes)
+        {
+            auto isReference = mode.choice == 0;
+            auto& dest = isReference ? reference : rendered;
+            dest.clear();
+
+            auto r = runBench(sampleRate, blockSize, seconds, warmup, pattern, notesPerChord, engine,
+                              [&](GayPolyCommunistAudioProcessor& p)
+                              {
+                                  applyRouting(p, routing);
+                                  setChoice(p, "Control Rate", mode.choice);
+                                  setChoice(p, "Control Interp", (int)mode.interpolation);
+                              },
+                              &dest);
+
+            double maxError = 0.0, errorEnergy = 0.0;
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                auto* a = reference.getReadPointer(ch);
+                auto* b = dest.getReadPointer(ch);
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    auto diff = (double)b[i] - (double)a[i];
+                    maxError = jmax(maxError, std::abs(diff));
+                    errorEnergy += diff * diff;
+
+                    if (isReference)
+                        referenceEnergy += (double)a[i] * (double)a[i];
+                }
+            }
+
+            if (isReference)
+                referenceUs = r.averageBlockUs;
+
+            auto errorDb = (errorEnergy > 0.0 && referenceEnergy > 0.0) ? 10.0 * std::log10(errorEnergy / referenceEnergy) : -999.0;
+
+            std::cout << String::formatted("%-8s %-7s %12.2f %10.2f %8.2fx %12.6f %14.1f",
+                                           ControlTicks::getChoices()[mode.choice].toRawUTF8(),
+                                           isReference ? "-" : (mode.interpolation == ControlTicks::cubic ? "cubic" : "linear"),
+                                           r.averageBlockUs, r.realtimeFactor,
+                                           r.averageBlockUs > 0.0 ? referenceUs / r.averageBlockUs : 0.0,
+                                           maxError, errorDb) << std::endl;
+        }
+
+        return 0;
+    }
+
+    //==============================================================================
+    // automation timing / cost
+    enum class AutomationStyle
+    {
+        none,
+        update,     // what processBlock used to do, every change reloads everything and lands at the block start
+        block,      // host style, the change lands at the block start and only that parameter moves
+        sample      // queueParameterChange at the exact sample
+    };
+
+    // a filter sweep, a new value every interval samples
+    float automationValue(int64 position, double sampleRate)
+    {
+        auto phase = MathConstants<double>::twoPi * (double)position / (sampleRate * 0.5);
+        return (float)jmap(0.5 + 0.5 * std::sin(phase), 200.0, 8000.0);
+    }
+
+    BenchResult runAutomated(AutomationStyle style, int interval, double sampleRate, int blockSize, double seconds, double warmup,
+                             ScriptedMidi::Pattern pattern, int notesPerChord, GaySynth::EngineMode engine, AudioBuffer<float>& dest)
+    {
+        dest.clear();
+
+        return runBench(sampleRate, blockSize, seconds, warmup, pattern, notesPerChord, engine, nullptr, &dest,
+                        [=](GayPolyCommunistAudioProcessor& p, int64 position, int numSamples)
+                        {
+                            if (style == AutomationStyle::none)
+                                return;
+
+                            auto* param = p.getValueTree().getParameter("Filter Freq");
+
+                            for (auto change = ((position + interval - 1) / interval) * interval; change < position + numSamples; change += interval)
+                            {
+                                auto value = automationValue(change, sampleRate);
+
+                                if (style == AutomationStyle::sample)
+                                {
+                                    p.queueParameterChange("Filter Freq", value, (int)(change - position));
+                                    continue;
+                                }
+
+                                param->setValueNotifyingHost(param->convertTo0to1(value));
+
+                                if (style == AutomationStyle::update)
+                                    p.update();
+                            }
+                        });
+    }
+
+    int runAutomation(const ArgumentList& args, double sampleRate, const Array<int>& blockSizes, double seconds, double warmup,
+                      ScriptedMidi::Pattern pattern, int notesPerChord, GaySynth::EngineMode engine)
+    {
+        auto interval = args.containsOption("--interval") ? jmax(1, args.getValueForOption("--interval").getIntValue()) : 64;
+        auto numSamples = (int)(seconds * sampleRate);
+
+        // sample accurate at the smallest block is what everything gets compared to
+        auto smallest = blockSizes[0];
+        for (auto blockSize : blockSizes)
+            smallest = jmin(smallest, blockSize);
+
+        AudioBuffer<float> reference(2, numSamples), rendered(2, numSamples);
+        runAutomated(AutomationStyle::sample, interval, sampleRate, smallest, seconds, warmup, pattern, notesPerChord, engine, reference);
+
+        double referenceEnergy = 0.0;
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                referenceEnergy += (double)reference.getSample(ch, i) * (double)reference.getSample(ch, i);
+
+        const char* names[] = { "none", "update", "block", "sample" };
+
+        std::cout << String::formatted("%6s %-7s %12s %10s %14s %12s", "block", "style", "us/block", "rt-factor", "changes/block", "error (dB)") << std::endl;
+
+        for (auto blockSize : blockSizes)
+        {
+            for (auto style : { AutomationStyle::none, AutomationStyle::update, AutomationStyle::block, AutomationStyle::sample })
+            {
+                auto r = runAutomated(style, interval, sampleRate, blockSize, seconds, warmup, pattern, notesPerChord, engine, rendered);
+
+                double errorEnergy = 0.0;
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        auto diff = (double)rendered.getSample(ch, i) - (double)reference.getSample(ch, i);
+                        errorEnergy += diff * diff;
+                    }
+                }
+
+                auto errorDb = (errorEnergy > 0.0 && referenceEnergy > 0.0) ? 10.0 * std::log10(errorEnergy / referenceEnergy) : -999.0;
+                auto changesPerBlock = style == AutomationStyle::none ? 0.0 : (double)blockSize / (double)interval;
+
+                std::cout << String::formatted("%6d %-7s %12.2f %10.2f %14.2f %12.1f",
+                                               blockSize, names[(int)style], r.averageBlockUs, r.realtimeFactor,
+                                               changesPerBlock, errorDb) << std::endl;
+            }
+        }
+
+        return 0;
+    }
+
+   #if GPC_RT_SANITIZER
+    // returns the number of violations seen
+    int runRealtimeCheck(double sampleRate, int blockSize, double seconds, ScriptedMidi::Pattern pattern, int notesPerChord)
+    {
+        auto processor = std::make_unique<GayPolyCommunistAudioProcessor>();
+        processor->setPlayConfigDetails(0, 2, sampleRate, blockSize);
+        processor->prepareToPlay(sampleRate, blockSize);
+        processor->waitForWaveTables();
+
+        auto totalSamples = (int64)(seconds * sampleRate);
+        ScriptedMidi midiScript(pattern, notesPerChord, sampleRate, totalSamples);
+
+        // whatever the editor can move, the host can automate
+        Array<RangedAudioParameter*> automated;
+        for (auto* p : processor->getParameters())
+            if (auto* ranged = dynamic_cast<RangedAudioParameter*>(p))
+                automated.add(ranged);
+
+        AudioBuffer<float> wave(1, 2049);
+        for (int i = 0; i < wave.getNumSamples(); ++i)
+            wave.setSample(0, i, std::sin(MathConstants<float>::twoPi * (float)i / 2048.f));
+
+        RealtimeSanitizer::clearViolations();
+
+        std::thread audioThread([&]
+        {
+            AudioBuffer<float> buffer(2, blockSize);
+            MidiBuffer midi;
+            midi.ensureSize(4096);
+            Random random(1234);
+            int block = 0;
+
+            for (int64 position = 0; position < totalSamples; position += blockSize, ++block)
+            {
+                // a host sets automation from the audio thread, just not from inside processBlock
+                if (block % 4 == 0)
+                    for (int i = 0; i < 4; ++i)
+                        automated[random.nextInt(automated.size())]->setValueNotifyingHost(random.nextFloat());
+
+                if (position <= totalSamples / 2 && position + blockSize > totalSamples / 2)
+                    MessageManager::callAsync([&] { processor->loadTableFromBuffer(wave, 1); });
+
+                auto numSamples = (int)jmin((int64)blockSize, totalSamples - position);
+                buffer.setSize(2, numSamples, false, false, true);
+                buffer.clear();
+                midiScript.fillBlock(midi, position, numSamples);
+                processor->processBlock(buffer, midi);
+
+                // give the message thread a chance to flush parameter changes into the value tree
+                Thread::sleep(1);
+            }
+
+            MessageManager::callAsync([] { MessageManager::getInstance()->stopDispatchLoop(); });
+        });
+
+        MessageManager::getInstance()->runDispatchLoop();
+        audioThread.join();
+
+        processor->releaseResources();
+        return RealtimeSanitizer::getNumViolations();
+    }
+   #endif
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+    ScopedJuceInitialiser_GUI juceInit; // the processor owns gui-side objects (look and feels etc.)
+
+    auto seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 10.0;
+    auto warmup = args.containsOption("--warmup") ? args.getValueForOption("--warmup").getDoubleValue() : 1.0;
+    auto notes = args.containsOption("--notes") ? args.getValueForOption("--notes").getIntValue() : 4;
+    auto pattern = ScriptedMidi::patternFromName(args.getValueForOption("--pattern"));
+    auto engine = engineFromName(args.getValueForOption("--engine"));
+    numRenderThreads = args.containsOption("--threads") ? jmax(0, args.getValueForOption("--threads").getIntValue()) : -1;
+
+    auto blockSizes = parseIntList(args.containsOption("--block-sizes") ? args.getValueForOption("--block-sizes") : "64,256,1024");
+    auto sampleRates = parseIntList(args.containsOption("--sample-rates") ? args.getValueForOption("--sample-rates") : "44100,48000,96000");
+
+    if (seconds <= 0.0 || blockSizes.isEmpty() || sampleRates.isEmpty())
+    {
+        std::cerr << "usage: gpc_bench [--scaling|--rt-check|--control-rate|--automation] [--seconds=10] [--block-sizes=64,256,1024] [--sample-rates=44100,48000,96000]"
+                     " [--pattern=chords|arp|pad|burst] [--notes=4] [--warmup=1] [--engine=voice|lanes|parallel] [--threads=n]" << std::endl;
+        return 1;
+    }
+
+    if (args.containsOption("--scaling"))
+    {
+        auto scalingSeconds = args.containsOption("--seconds") ? seconds : 2.0;
+        auto scalingRate = args.containsOption("--sample-rates") ? sampleRates[0] : 48000;
+        auto scalingBlock = args.containsOption("--block-sizes") ? blockSizes[0] : 256;
+
+        return runScaling(args, (double)scalingRate, scalingBlock, scalingSeconds, warmup, engine);
+    }
+
+    if (args.containsOption("--control-rate"))
+    {
+        auto controlSeconds = args.containsOption("--seconds") ? seconds : 2.0;
+        auto controlRate = args.containsOption("--sample-rates") ? sampleRates[0] : 48000;
+        auto controlBlock = args.containsOption("--block-sizes") ? blockSizes[0] : 256;
+
+        return runControlRate(args, (double)controlRate, controlBlock, controlSeconds, warmup, pattern, notes, engine);
+    }
+
+    if (args.containsOption("--automation"))
+    {
+        auto automationSeconds = args.containsOption("--seconds") ? seconds : 2.0;
+        auto automationRate = args.containsOption("--sample-rates") ? sampleRates[0] : 48000;
+        auto automationBlocks = args.containsOption("--block-sizes") ? blockSizes : Array<int> { 64, 512, 2048 };
+
+        return runAutomation(args, (double)automationRate, automationBlocks, automationSeconds, warmup, pattern, notes, engine);
+    }
+
+    if (args.containsOption("--rt-check"))
+    {
+       #if GPC_RT_SANITIZER
+        int total = 0;
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto blockSize : blockSizes)
+            {
+                auto found = runRealtimeCheck((double)sampleRate, blockSize, seconds, pattern, notes);
+                std::cout << String::formatted("%8d %6d  %d rt violations", sampleRate, blockSize, found) << std::endl;
+                RealtimeSanitizer::printViolations(stdout);
+                total += found;
+            }
+        }
+
+        return total > 0 ? 1 : 0;
+       #else
+        std::cerr << "--rt-check needs a build configured with -DGPC_RT_SANITIZER=ON" << std::endl;
+        return 1;
+       #endif
+    }
+
+    std::cout << String::formatted("%8s %6s %10s %14s %12s %10s %8s",
+                                   "rate", "block", "rt-factor", "ns/smp/voice", "worst(us)", "worst/blk", "voices") << std::endl;
+
+    for (auto sampleRate : sampleRates)
+    {
+        for (auto blockSize : blockSizes)
+        {
+            auto r = runBench((double)sampleRate, blockSize, seconds, warmup, pattern, notes, engine);
+
+            std::cout << String::formatted("%8d %6d %10.2f %14.2f %12.2f %9.1f%% %8.2f",
+                                           (int)r.sampleRate, r.blockSize, r.realtimeFactor, r.nsPerSampleVoice,
+                                           r.worstBlockUs, r.worstBlockBudget * 100.0, r.averageVoices) << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: 17 Oct 2026 11:20:47am
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Processor/PluginProcessor.h"
+
+/*
+    Drives a GayPolyCommunistAudioProcessor through a sample stamped MidiMessageSequence with no audio device.
+    The processor is used exactly as a host would use it (prepareToPlay / processBlock), just as fast as the cpu allows
+*/
+class OfflineRenderer
+{
+public:
+    struct Stats
+    {
+        int64 samples = 0;
+        int blocks = 0;
+        double seconds = 0.0;           // wall clock time spent inside processBlock
+        double worstBlockSeconds = 0.0;
+    };
+
+    OfflineRenderer(GayPolyCommunistAudioProcessor& p, double sampleRate, int maxBlockSize)
+        : processor(p), blockSize(maxBlockSize), blockBuffer(2, maxBlockSize)
+    {
+        processor.setPlayConfigDetails(0, 2, sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+        processor.waitForWaveTables(); // the tables load in the background, a render has to start on them
+        midi.ensureSize(8192);
+    }
+
+    ~OfflineRenderer()
+    {
+        processor.releaseResources();
+    }
+
+    /*
+        Renders [startSample, startSample + numSamples) of the sequence and adds it into dest at destStart.
+        Adding (rather than copying) lets separately rendered shards overlap their release tails
+    */
+    Stats render(const MidiMessageSequence& sequence, int64 startSample, int64 numSamples,
+                 AudioBuffer<float>& dest, int64 destStart)
+    {
+        Stats stats;
+        auto eventIndex = sequence.getNextIndexAtTime((double)startSample);
+        auto endSample = startSample + numSamples;
+
+        for (auto position = startSample; position < endSample; position += blockSize)
+        {
+            auto n = (int)jmin((int64)blockSize, endSample - position);
+
+            midi.clear();
+            while (eventIndex < sequence.getNumEvents())
+            {
+                auto& m = sequence.getEventPointer(eventIndex)->message;
+                if (m.getTimeStamp() >= (double)(position + n))
+                    break;
+
+                midi.addEvent(m, jlimit(0, n - 1, (int)(m.getTimeStamp() - (double)position)));
+                ++eventIndex;
+            }
+
+            blockBuffer.setSize(2, n, false, false, true);
+            blockBuffer.clear();
+
+            auto start = Time::getHighResolutionTicks();
+            processor.processBlock(blockBuffer, midi);
+            auto elapsed = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+
+            stats.seconds += elapsed;
+            stats.worstBlockSeconds = jmax(stats.worstBlockSeconds, elapsed);
+            stats.samples += n;
+            ++stats.blocks;
+
+            auto destPos = (int)(destStart + position - startSample);
+            for (int ch = 0; ch < dest.getNumChannels(); ++ch)
+                dest.addFrom(ch, destPos, blockBuffer, jmin(ch, blockBuffer.getNumChannels() - 1), 0, n);
+        }
+
+        return stats;
+    }
+
+    //==============================================================================
+    // merges every track of a standard midi file into one sequence stamped in samples
+    static MidiMessageSequence loadMidiFile(const File& file, double sampleRate)
+    {
+        MidiMessageSequence merged;
+        MidiFile midiFile;
+        FileInputStream stream(file);
+
+        if (! stream.openedOk() || ! midiFile.readFrom(stream))
+            return merged;
+
+        midiFile.convertTimestampTicksToSeconds();
+
+        for (int t = 0; t < midiFile.getNumTracks(); ++t)
+            merged.addSequence(*midiFile.getTrack(t), 0.0);
+
+        for (int i = 0; i < merged.getNumEvents(); ++i)
+        {
+            auto& m = merged.getEventPointer(i)->message;
+            m.setTimeStamp(std::round(m.getTimeStamp() * sampleRate));
+        }
+
+        merged.sort();
+        merged.updateMatchedPairs();
+        return merged;
+    }
+
+    static bool loadPreset(GayPolyCommunistAudioProcessor& p, const File& presetFile)
+    {
+        MemoryBlock state;
+        if (! presetFile.loadFileAsData(state) || state.getSize() == 0)
+            return false;
+
+        p.setStateInformation(state.getData(), (int)state.getSize());
+        return true;
+    }
+
+    static bool writeWav(const File& file, const AudioBuffer<float>& audio, double sampleRate, int bitsPerSample)
+    {
+        file.deleteFile();
+        std::unique_ptr<OutputStream> stream(file.createOutputStream());
+        if (stream == nullptr)
+            return false;
+
+        WavAudioFormat wav;
+        std::unique_ptr<AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+                                                                      (unsigned int)audio.getNumChannels(),
+                                                                      bitsPerSample, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release(); // the writer owns the stream now
+        return writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+    }
+
+private:
+    GayPolyCommunistAudioProcessor& processor;
+    int blockSize = 512;
+    AudioBuffer<float> blockBuffer;
+    MidiBuffer midi;
+};
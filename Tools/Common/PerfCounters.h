@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    PerfCounters.h
+    Created: 17 Oct 2026 1:37:55pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+/*
+    Hardware counters around a piece of code: cycles, cache misses, branch mispredicts.
+    Uses perf_event_open on linux. Anywhere else (or when the kernel won't hand out counters, see
+    /proc/sys/kernel/perf_event_paranoid) isAvailable() is false and callers should fall back to wall time
+*/
+class PerfCounters
+{
+public:
+    enum Counter
+    {
+        cycles,
+        cacheMisses,
+        branchMisses,
+        numCounters
+    };
+
+    PerfCounters()
+    {
+       #if JUCE_LINUX
+        const uint64 configs[] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+        for (int i = 0; i < numCounters; ++i)
+        {
+            perf_event_attr attr {};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+       #endif
+    }
+
+    ~PerfCounters()
+    {
+       #if JUCE_LINUX
+        for (auto fd : fds)
+            if (fd >= 0)
+                close(fd);
+       #endif
+    }
+
+    bool isAvailable(Counter c) const
+    {
+        return fds[c] >= 0;
+    }
+
+    void start()
+    {
+       #if JUCE_LINUX
+        for (auto fd : fds)
+        {
+            if (fd >= 0)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+       #endif
+    }
+
+    void stop()
+    {
+       #if JUCE_LINUX
+        for (int i = 0; i < numCounters; ++i)
+        {
+            values[i] = 0;
+            if (fds[i] >= 0)
+            {
+                ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+                uint64 v = 0;
+                if (read(fds[i], &v, sizeof(v)) == (ssize_t)sizeof(v))
+                    values[i] = v;
+            }
+        }
+       #endif
+    }
+
+    uint64 get(Counter c) const
+    {
+        return values[c];
+    }
+
+private:
+    int fds[numCounters] = { -1, -1, -1 };
+    uint64 values[numCounters] = {};
+
+    JUCE_DECLARE_NON_COPYABLE(PerfCounters)
+};
@@ -0,0 +1,288 @@
+/*
+  ==============================================================================
+
+    RealtimeSanitizer.cpp
+    Created: 17 Oct 2026 3:58:27pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+/*
+    The interposers behind RealtimeSanitizer.h.
+    Defining malloc & friends in the executable makes every call in the process (libc and JUCE included) land
+    here first. Outside a GPC_RT_AUDIO_SCOPE they just forward to the real thing, inside one they record what
+    happened plus a backtrace and then still forward, so the render carries on and all violations get reported.
+
+    Recording itself can't allocate or lock: violations go in a fixed array claimed with an atomic counter, and
+    checking is switched off on the thread while the backtrace is taken (the unwinder takes locks of its own).
+    glibc only - the build refuses GPC_RT_SANITIZER anywhere else.
+*/
+
+#ifndef _GNU_SOURCE
+ #define _GNU_SOURCE
+#endif
+
+#include "Processor/RealtimeSanitizer.h"
+#include <atomic>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace
+{
+    struct Violation
+    {
+        RealtimeSanitizer::Kind kind;
+        const char* function;
+        int numFrames;
+        void* frames[32];
+    };
+
+    constexpr int maxStored = 256;
+    Violation stored[maxStored];
+    std::atomic<int> numViolations { 0 };
+
+    //==============================================================================
+    // dlsym calls calloc before the real one has been looked up, those few bytes come from here and are never freed
+    alignas(16) char bootstrapHeap[8192];
+    size_t bootstrapUsed = 0;
+    bool resolving = false;
+
+    bool isBootstrap(void* p)
+    {
+        return p >= (void*)bootstrapHeap && p < (void*)(bootstrapHeap + sizeof(bootstrapHeap));
+    }
+
+    void* bootstrapAlloc(size_t size)
+    {
+        size = (size + 15) & ~(size_t)15;
+        if (bootstrapUsed + size > sizeof(bootstrapHeap))
+            return nullptr;
+
+        auto* p = bootstrapHeap + bootstrapUsed;
+        bootstrapUsed += size;
+        return p;
+    }
+
+    template <typename Fn>
+    Fn real(Fn& cached, const char* name)
+    {
+        if (cached == nullptr)
+        {
+            resolving = true;
+            cached = (Fn)dlsym(RTLD_NEXT, name);
+            resolving = false;
+        }
+
+        return cached;
+    }
+
+    void record(RealtimeSanitizer::Kind kind, const char* function)
+    {
+        if (RealtimeSanitizer::audioThreadDepth() <= 0 || resolving)
+            return;
+
+        RealtimeSanitizer::ScopedAllow allow;
+        auto index = numViolations.fetch_add(1);
+
+        if (index < maxStored)
+        {
+            auto& v = stored[index];
+            v.kind = kind;
+            v.function = function;
+            v.numFrames = backtrace(v.frames, 32);
+        }
+    }
+
+    // backtrace() loads libgcc the first time it's called, get that out of the way before anything is checked
+    struct WarmUp
+    {
+        WarmUp()
+        {
+            void* frames[2];
+            backtrace(frames, 2);
+        }
+    } warmUp;
+
+    using MallocFn = void* (*)(size_t);
+    using CallocFn = void* (*)(size_t, size_t);
+    using ReallocFn = void* (*)(void*, size_t);
+    using FreeFn = void (*)(void*);
+    using MemalignFn = int (*)(void**, size_t, size_t);
+    using AlignedAllocFn = void* (*)(size_t, size_t);
+    using MutexLockFn = int (*)(pthread_mutex_t*);
+    using OpenFn = int (*)(const char*, int, ...);
+    using OpenAtFn = int (*)(int, const char*, int, ...);
+    using ReadFn = ssize_t (*)(int, void*, size_t);
+    using WriteFn = ssize_t (*)(int, const void*, size_t);
+    using FopenFn = FILE* (*)(const char*, const char*);
+
+    MallocFn realMalloc = nullptr;
+    CallocFn realCalloc = nullptr;
+    ReallocFn realRealloc = nullptr;
+    FreeFn realFree = nullptr;
+    MemalignFn realPosixMemalign = nullptr;
+    AlignedAllocFn realAlignedAlloc = nullptr;
+    MutexLockFn realMutexLock = nullptr;
+    OpenFn realOpen = nullptr;
+    OpenAtFn realOpenAt = nullptr;
+    ReadFn realRead = nullptr;
+    WriteFn realWrite = nullptr;
+    FopenFn realFopen = nullptr;
+
+    const char* kindName(RealtimeSanitizer::Kind kind)
+    {
+        switch (kind)
+        {
+        case RealtimeSanitizer::allocation:     return "allocation";
+        case RealtimeSanitizer::deallocation:   return "deallocation";
+        case RealtimeSanitizer::mutexLock:      return "mutex lock";
+        case RealtimeSanitizer::fileIO:         return "file i/o";
+        default:                                return "?";
+        }
+    }
+}
+
+//==============================================================================
+int RealtimeSanitizer::getNumViolations() noexcept
+{
+    return numViolations.load();
+}
+
+void RealtimeSanitizer::clearViolations() noexcept
+{
+    numViolations = 0;
+}
+
+void RealtimeSanitizer::printViolations(FILE* out)
+{
+    ScopedAllow allow;
+    auto total = numViolations.load();
+
+    for (int i = 0; i < total && i < maxStored; ++i)
+    {
+        auto& v = stored[i];
+        fprintf(out, "rt violation %d: %s (%s) inside processBlock\n", i + 1, kindName(v.kind), v.function);
+        fflush(out);
+        backtrace_symbols_fd(v.frames + 1, v.numFrames - 1, fileno(out)); // frame 0 is the interposer itself
+        fprintf(out, "\n");
+    }
+
+    if (total > maxStored)
+        fprintf(out, "... and %d more\n", total - maxStored);
+}
+
+//==============================================================================
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        if (resolving)
+            return bootstrapAlloc(size);
+
+        record(RealtimeSanitizer::allocation, "malloc");
+        return real(realMalloc, "malloc")(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        if (resolving)
+        {
+            auto* p = bootstrapAlloc(count * size);
+            if (p != nullptr)
+                memset(p, 0, count * size);
+
+            return p;
+        }
+
+        record(RealtimeSanitizer::allocation, "calloc");
+        return real(realCalloc, "calloc")(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        record(RealtimeSanitizer::allocation, "realloc");
+        return real(realRealloc, "realloc")(ptr, size);
+    }
+
+    void free(void* ptr)
+    {
+        if (ptr == nullptr || isBootstrap(ptr))
+            return;
+
+        record(RealtimeSanitizer::deallocation, "free");
+        real(realFree, "free")(ptr);
+    }
+
+    int posix_memalign(void** ptr, size_t alignment, size_t size)
+    {
+        record(RealtimeSanitizer::allocation, "posix_memalign");
+        return real(realPosixMemalign, "posix_memalign")(ptr, alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        record(RealtimeSanitizer::allocation, "aligned_alloc");
+        return real(realAlignedAlloc, "aligned_alloc")(alignment, size);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        record(RealtimeSanitizer::mutexLock, "pthread_mutex_lock");
+        return real(realMutexLock, "pthread_mutex_lock")(mutex);
+    }
+
+    int open(const char* path, int flags, ...)
+    {
+        mode_t mode = 0;
+        if ((flags & O_CREAT) != 0)
+        {
+            va_list args;
+            va_start(args, flags);
+            mode = (mode_t)va_arg(args, int);
+            va_end(args);
+        }
+
+        record(RealtimeSanitizer::fileIO, "open");
+        return real(realOpen, "open")(path, flags, mode);
+    }
+
+    int openat(int dirfd, const char* path, int flags, ...)
+    {
+        mode_t mode = 0;
+        if ((flags & O_CREAT) != 0)
+        {
+            va_list args;
+            va_start(args, flags);
+            mode = (mode_t)va_arg(args, int);
+            va_end(args);
+        }
+
+        record(RealtimeSanitizer::fileIO, "openat");
+        return real(realOpenAt, "openat")(dirfd, path, flags, mode);
+    }
+
+    ssize_t read(int fd, void* buffer, size_t size)
+    {
+        record(RealtimeSanitizer::fileIO, "read");
+        return real(realRead, "read")(fd, buffer, size);
+    }
+
+    ssize_t write(int fd, const void* buffer, size_t size)
+    {
+        record(RealtimeSanitizer::fileIO, "write");
+        return real(realWrite, "write")(fd, buffer, size);
+    }
+
+    FILE* fopen(const char* path, const char* mode)
+    {
+        record(RealtimeSanitizer::fileIO, "fopen");
+        return real(realFopen, "fopen")(path, mode);
+    }
+}
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    ScriptedMidi.h
+    Created: 17 Oct 2026 9:41:12am
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/*
+    Deterministic note patterns for the headless tools.
+    The whole sequence is built up front (sample timestamps) so handing it to the processor block by block
+    never allocates or generates anything while the render is being timed
+*/
+class ScriptedMidi
+{
+public:
+    enum Pattern
+    {
+        chords,   // a new chord every beat, held for most of it
+        arpeggio, // one note at a time, sixteenths
+        pad,      // long overlapping chords, every voice ringing into the next
+        burst,    // sequencer ratchets, notesPerChord * 4 notes a few ms apart every half beat, nearly all of them steal
+    };
+
+    ScriptedMidi(Pattern p, int notesPerChord, double sampleRate, int64 lengthInSamples, double bpm = 120.0)
+    {
+        auto samplesPerBeat = sampleRate * 60.0 / bpm;
+        const int roots[] = { 48, 53, 55, 50, 45, 52 };
+        const int chordShape[] = { 0, 4, 7, 11, 14, 17, 21, 24 };
+        notesPerChord = jlimit(1, 128, notesPerChord);
+
+        int step = 0;
+        for (double t = 0.0; t < (double)lengthInSamples; ++step)
+        {
+            auto root = roots[step % numElementsInArray(roots)];
+
+            if (p == arpeggio)
+            {
+                auto length = samplesPerBeat * 0.25;
+                auto note = root + chordShape[step % jmin(notesPerChord, (int)numElementsInArray(chordShape))] + 12;
+                addNote(note, 0.8f, t, t + length * 0.9);
+                t += length;
+            }
+            else if (p == burst)
+            {
+                auto spacing = sampleRate * 0.003;
+
+                for (int n = 0; n < notesPerChord * 4; ++n)
+                {
+                    auto note = root + chordShape[n % numElementsInArray(chordShape)] + 12 * ((n / numElementsInArray(chordShape)) % 3);
+                    addNote(note, 0.8f, t + n * spacing, t + n * spacing + samplesPerBeat);
+                }
+
+                t += samplesPerBeat * 0.5;
+            }
+            else
+            {
+                auto length = (p == pad) ? samplesPerBeat * 4.0 : samplesPerBeat;
+                auto hold = (p == pad) ? length * 1.5 : length * 0.8;
+
+                // past 16 notes the stacked shape runs off the keyboard, so big chords become clusters of distinct notes
+                auto clusterBase = jlimit(0, 128 - notesPerChord, root - notesPerChord / 2);
+
+                for (int n = 0; n < notesPerChord; ++n)
+                {
+                    auto interval = chordShape[n % numElementsInArray(chordShape)] + 12 * (n / numElementsInArray(chordShape));
+                    addNote(notesPerChord > 16 ? clusterBase + n : root + interval, 0.7f, t, t + hold);
+                }
+                t += length;
+            }
+        }
+
+        sequence.sort();
+        sequence.updateMatchedPairs();
+    }
+
+    // adds every event in [startSample, startSample + numSamples) to the buffer, positions relative to the block
+    void fillBlock(MidiBuffer& midi, int64 startSample, int numSamples)
+    {
+        midi.clear();
+        auto endSample = (double)(startSample + numSamples);
+
+        while (nextEvent < sequence.getNumEvents())
+        {
+            auto& m = sequence.getEventPointer(nextEvent)->message;
+            if (m.getTimeStamp() >= endSample)
+                break;
+
+            midi.addEvent(m, jlimit(0, numSamples - 1, (int)(m.getTimeStamp() - (double)startSample)));
+            ++nextEvent;
+        }
+    }
+
+    void rewind()
+    {
+        nextEvent = 0;
+    }
+
+    MidiMessageSequence& getSequence()
+    {
+        return sequence;
+    }
+
+    static Pattern patternFromName(const String& name)
+    {
+        if (name == "arp" || name == "arpeggio")
+            return arpeggio;
+        if (name == "pad")
+            return pad;
+        if (name == "burst")
+            return burst;
+        return chords;
+    }
+
+private:
+    void addNote(int note, float velocity, double start, double end)
+    {
+        sequence.addEvent(MidiMessage::noteOn(1, jlimit(0, 127, note), velocity), start);
+        sequence.addEvent(MidiMessage::noteOff(1, jlimit(0, 127, note)), end);
+    }
+
+    MidiMessageSequence sequence;
+    int nextEvent = 0;
+};
@@ -0,0 +1,274 @@
+/*
+  ==============================================================================
+
+    GPCGolden.cpp
+    Created: 17 Oct 2026 3:05:44pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "OfflineRenderer.h"
+#include "GoldenCorpus.h"
+
+/*
+    Golden audio null test.
+    Renders every patch x sequence in GoldenCorpus through the processor and compares against the stored reference wavs.
+    Each case is checked twice, each against its own wav:
+        reference quality - <case>.wav, must match bit for bit
+        normal quality    - <case>.normal.wav, whatever the fast paths do, held to --max-abs and --max-spectral-db
+    They have separate wavs because they don't filter the same way: reference quality keeps dsp::LadderFilter
+    (cutoff once a block, exact tanh), normal quality runs LadderLanes (cutoff per sample, approximated tanh).
+    Returns 1 if anything fails, and drops <case>.<mode>.render.wav / .diff.wav into --diffs for a listen.
+
+    gpc_golden [--refs=Tools/Golden/References] [--diffs=golden-diffs] [--update] [--filter=name]
+               [--max-abs=1.0e-4] [--max-spectral-db=-80] [--sample-rate=48000] [--block-size=256]
+
+    --update re-renders both sets of references instead of checking them. Only do that when a
+    change to the sound is intentional, and say so in the commit.
+
+    The references are committed in Tools/Golden/References, two 32 bit wavs per case. A commit that changes the
+    sound on purpose commits the re-rendered wavs along with it, otherwise every commit after it fails here.
+    With no references at all there's nothing to null against, so that's an error rather than a pass.
+*/
+
+namespace
+{
+    struct Comparison
+    {
+        bool sameLength = true;
+        float maxAbsError = 0.f;
+        double spectralDb = -std::numeric_limits<double>::infinity(); // error energy relative to the reference, per fft bin
+    };
+
+    AudioBuffer<float> renderCase(const GoldenCorpus::Patch& patch, const GoldenCorpus::Sequence& seq,
+                                  double sampleRate, int blockSize, bool referenceQuality)
+    {
+        GayPolyCommunistAudioProcessor processor;
+        GoldenCorpus::loadTables(processor);
+        GoldenCorpus::applyPatch(processor, patch);
+        processor.setReferenceQuality(referenceQuality);
+
+        auto length = (int64)(seq.seconds * sampleRate);
+        ScriptedMidi midi(seq.pattern, seq.notes, sampleRate, length);
+
+        AudioBuffer<float> output(2, (int)length);
+        output.clear();
+
+        OfflineRenderer renderer(processor, sampleRate, blockSize);
+        renderer.render(midi.getSequence(), 0, length, output, 0);
+        return output;
+    }
+
+    bool readWav(const File& file, AudioBuffer<float>& dest)
+    {
+        AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<AudioFormatReader> reader(formats.createReaderFor(file));
+        if (reader == nullptr)
+            return false;
+
+        dest.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
+        return reader->read(&dest, 0, (int)reader->lengthInSamples, 0, true, true);
+    }
+
+    double spectralDifference(const AudioBuffer<float>& reference, const AudioBuffer<float>& rendered)
+    {
+        const int order = 11;
+        const int fftSize = 1 << order;
+        dsp::FFT fft(order);
+        dsp::WindowingFunction<float> window((size_t)fftSize, dsp::WindowingFunction<float>::hann, false);
+
+        std::vector<float> refFrame((size_t)fftSize * 2), renFrame((size_t)fftSize * 2);
+        double errorEnergy = 0.0, refEnergy = 0.0;
+        auto numSamples = jmin(reference.getNumSamples(), rendered.getNumSamples());
+        auto numChannels = jmin(reference.getNumChannels(), rendered.getNumChannels());
+
+        for (int start = 0; start + fftSize <= numSamples; start += fftSize / 2)
+        {
+            std::fill(refFrame.begin(), refFrame.end(), 0.f);
+            std::fill(renFrame.begin(), renFrame.end(), 0.f);
+
+            // mono sum is plenty, the voices are the same on both sides
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                FloatVectorOperations::add(refFrame.data(), reference.getReadPointer(ch, start), fftSize);
+                FloatVectorOperations::add(renFrame.data(), rendered.getReadPointer(ch, start), fftSize);
+            }
+
+            window.multiplyWithWindowingTable(refFrame.data(), (size_t)fftSize);
+            window.multiplyWithWindowingTable(renFrame.data(), (size_t)fftSize);
+            fft.performFrequencyOnlyForwardTransform(refFrame.data());
+            fft.performFrequencyOnlyForwardTransform(renFrame.data());
+
+            for (int bin = 0; bin <= fftSize / 2; ++bin)
+            {
+                auto diff = (double)refFrame[(size_t)bin] - (double)renFrame[(size_t)bin];
+                errorEnergy += diff * diff;
+                refEnergy += (double)refFrame[(size_t)bin] * (double)refFrame[(size_t)bin];
+            }
+        }
+
+        if (errorEnergy <= 0.0)
+            return -std::numeric_limits<double>::infinity();
+
+        // a silent reference with anything in the render is as wrong as it gets
+        return refEnergy > 0.0 ? 10.0 * std::log10(errorEnergy / refEnergy) : 0.0;
+    }
+
+    Comparison compare(const AudioBuffer<float>& reference, const AudioBuffer<float>& rendered)
+    {
+        Comparison c;
+        c.sameLength = reference.getNumSamples() == rendered.getNumSamples()
+                    && reference.getNumChannels() == rendered.getNumChannels();
+
+        auto numSamples = jmin(reference.getNumSamples(), rendered.getNumSamples());
+        auto numChannels = jmin(reference.getNumChannels(), rendered.getNumChannels());
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* a = reference.getReadPointer(ch);
+            auto* b = rendered.getReadPointer(ch);
+
+            for (int i = 0; i < numSamples; ++i)
+                c.maxAbsError = jmax(c.maxAbsError, std::abs(a[i] - b[i]));
+        }
+
+        c.spectralDb = spectralDifference(reference, rendered);
+        return c;
+    }
+
+    void writeDiffs(const File& diffDir, const String& name, const String& mode,
+                    const AudioBuffer<float>& reference, const AudioBuffer<float>& rendered, double sampleRate)
+    {
+        diffDir.createDirectory();
+
+        AudioBuffer<float> diff;
+        diff.makeCopyOf(rendered);
+
+        auto numSamples = jmin(reference.getNumSamples(), diff.getNumSamples());
+        for (int ch = 0; ch < jmin(reference.getNumChannels(), diff.getNumChannels()); ++ch)
+            diff.addFrom(ch, 0, reference, ch, 0, numSamples, -1.f);
+
+        OfflineRenderer::writeWav(diffDir.getChildFile(name + "." + mode + ".render.wav"), rendered, sampleRate, 32);
+        OfflineRenderer::writeWav(diffDir.getChildFile(name + "." + mode + ".diff.wav"), diff, sampleRate, 32);
+    }
+
+    String formatDb(double db)
+    {
+        return std::isinf(db) ? String("-inf") : String(db, 1);
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+    ScopedJuceInitialiser_GUI juceInit;
+
+    auto refDir = args.containsOption("--refs") ? args.getFileForOption("--refs")
+                                                : File::getCurrentWorkingDirectory().getChildFile("Tools/Golden/References");
+    auto diffDir = args.containsOption("--diffs") ? args.getFileForOption("--diffs")
+                                                  : File::getCurrentWorkingDirectory().getChildFile("golden-diffs");
+    auto update = args.containsOption("--update");
+    auto filter = args.getValueForOption("--filter");
+
+    auto maxAbs = args.containsOption("--max-abs") ? (float)args.getValueForOption("--max-abs").getDoubleValue() : 1.0e-4f;
+    auto maxSpectralDb = args.containsOption("--max-spectral-db") ? args.getValueForOption("--max-spectral-db").getDoubleValue() : -80.0;
+    auto sampleRate = args.containsOption("--sample-rate") ? args.getValueForOption("--sample-rate").getDoubleValue() : 48000.0;
+    auto blockSize = args.containsOption("--block-size") ? args.getValueForOption("--block-size").getIntValue() : 256;
+
+    if (sampleRate <= 0.0 || blockSize <= 0)
+    {
+        std::cerr << "usage: gpc_golden [--refs=dir] [--diffs=dir] [--update] [--filter=name] [--max-abs=1.0e-4]"
+                     " [--max-spectral-db=-80] [--sample-rate=48000] [--block-size=256]" << std::endl;
+        return 1;
+    }
+
+    if (update && ! refDir.createDirectory())
+    {
+        std::cerr << "couldn't create " << refDir.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (! update && refDir.getNumberOfChildFiles(File::findFiles, "*.wav") == 0)
+    {
+        std::cerr << "no references in " << refDir.getFullPathName() << ", nothing to check against.\n"
+                     "render them from a build whose sound is known good with --update and commit them" << std::endl;
+        return 1;
+    }
+
+    int numCases = 0, numFailed = 0;
+
+    for (auto& patch : GoldenCorpus::getPatches())
+    {
+        for (auto& seq : GoldenCorpus::getSequences())
+        {
+            auto name = patch.name + "_" + seq.name;
+            if (filter.isNotEmpty() && ! name.contains(filter))
+                continue;
+
+            ++numCases;
+
+            for (auto referenceQuality : { true, false })
+            {
+                auto mode = String(referenceQuality ? "reference" : "normal");
+                auto refFile = refDir.getChildFile(name + (referenceQuality ? ".wav" : ".normal.wav"));
+                auto rendered = renderCase(patch, seq, sampleRate, blockSize, referenceQuality);
+
+                if (update)
+                {
+                    auto ok = OfflineRenderer::writeWav(refFile, rendered, sampleRate, 32);
+                    std::cout << String::formatted("%-32s %-9s %s", name.toRawUTF8(), mode.toRawUTF8(),
+                                                   ok ? "written" : "WRITE FAILED") << std::endl;
+                    numFailed += ok ? 0 : 1;
+                    continue;
+                }
+
+                AudioBuffer<float> reference;
+                if (! readWav(refFile, reference))
+                {
+                    std::cout << String::formatted("%-32s %-9s MISSING %s", name.toRawUTF8(), mode.toRawUTF8(),
+                                                   refFile.getFullPathName().toRawUTF8()) << std::endl;
+                    ++numFailed;
+                    continue;
+                }
+
+                auto c = compare(reference, rendered);
+
+                // reference quality has no tolerance at all
+                auto passed = c.sameLength && (referenceQuality ? c.maxAbsError == 0.f
+                                                                : c.maxAbsError <= maxAbs && c.spectralDb <= maxSpectralDb);
+
+                std::cout << String::formatted("%-32s %-9s max abs %.3e  spectral %7s dB  %s%s",
+                                               name.toRawUTF8(), mode.toRawUTF8(), (double)c.maxAbsError,
+                                               formatDb(c.spectralDb).toRawUTF8(), passed ? "pass" : "FAIL",
+                                               c.sameLength ? "" : " (length differs)") << std::endl;
+
+                if (! passed)
+                {
+                    ++numFailed;
+                    writeDiffs(diffDir, name, mode, reference, rendered, sampleRate);
+                }
+            }
+        }
+    }
+
+    if (numCases == 0)
+    {
+        std::cerr << "no cases matched --filter=" << filter << std::endl;
+        return 1;
+    }
+
+    if (update)
+        std::cout << numCases * 2 << " references written to " << refDir.getFullPathName() << std::endl;
+    else if (numFailed > 0)
+        std::cout << numFailed << " failed, renders and diffs in " << diffDir.getFullPathName() << std::endl;
+    else
+        std::cout << "all " << numCases << " cases match" << std::endl;
+
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    GoldenCorpus.h
+    Created: 17 Oct 2026 2:48:31pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Processor/PluginProcessor.h"
+#include "ScriptedMidi.h"
+
+/*
+    The fixed set of patches x note patterns the golden null test renders.
+    Everything here is built in code, including the wavetables, so a reference rendered on one machine means the
+    same thing on every other one (the tables in ProgramData differ between installs).
+
+    Adding a case is fine, changing an existing one means re-rendering the references with --update
+*/
+namespace GoldenCorpus
+{
+    struct Patch
+    {
+        String name;
+        std::vector<std::pair<String, float>> values; // parameter id -> real (not normalised) value, anything missing stays default
+    };
+
+    struct Sequence
+    {
+        String name;
+        ScriptedMidi::Pattern pattern;
+        int notes;
+        double seconds;
+    };
+
+    inline std::vector<Patch> getPatches()
+    {
+        return {
+            { "init", {} },
+
+            { "filter-env", {
+                { "Filter Mode", 1.f }, { "Filter Freq", 800.f }, { "Filter Res", 0.6f },
+                { "Filter Env Source", 2.f }, { "Filter Env Scale", 0.8f },
+                { "ATTACK 2", 0.01f }, { "DECAY 2", 0.4f }, { "SUSTAIN 2", 0.2f }, { "RELEASE 2", 0.3f } } },
+
+            { "lfo-wave-pitch", {
+                { "Wave 1 LFO Source", 1.f }, { "Wave 1 LFO Scale", 0.7f }, { "LFO Rate 1", 3.f },
+                { "Pitch 2 LFO Source", 2.f }, { "Pitch 2 LFO Scale", 0.1f }, { "LFO Rate 2", 6.f },
+                { "Gain 1 Env Source", 3.f }, { "Gain 1 Env Scale", 0.5f } } },
+
+            // mode 0 is the HPF (2 is the filter off). The drive's LFO / env sources aren't routed anywhere, so it's a fixed drive
+            { "drive-hpf", {
+                { "Filter Mode", 0.f }, { "Filter Freq", 300.f }, { "Filter Res", 0.4f }, { "Filter Drive", 6.f } } },
+
+            { "env-rate-depth", {
+                { "LFO Rate Env Source 1", 2.f }, { "LFO Rate Env Scale 1", 0.6f },
+                { "LFO Depth Env Source 1", 3.f }, { "LFO Depth Env Scale 1", 0.6f },
+                { "Wave 2 LFO Source", 1.f }, { "Filter LFO Source", 1.f },
+                { "ATTACK 1", 0.0f }, { "RELEASE 1", 0.1f } } },
+
+            // a wide stereo stack on osc 1 and a mono one on osc 2, so reference quality has to render both
+            { "unison", {
+                { "Unison Voices 1", 7.f }, { "Unison Detune 1", 25.f }, { "Unison Spread 1", 0.8f }, { "Unison Blend 1", 0.7f },
+                { "Unison Voices 2", 3.f }, { "Unison Detune 2", 10.f }, { "Unison Spread 2", 0.f },
+                { "Wave 1 LFO Source", 1.f }, { "Wave 1 LFO Scale", 0.5f }, { "LFO Rate 1", 2.f } } },
+        };
+    }
+
+    inline std::vector<Sequence> getSequences()
+    {
+        return {
+            { "chords", ScriptedMidi::chords, 3, 4.0 },
+            { "arp", ScriptedMidi::arpeggio, 4, 3.0 },
+            { "pad", ScriptedMidi::pad, 4, 6.0 },
+        };
+    }
+
+    // saw morphing into a square for osc 1, sine into triangle for osc 2
+    inline AudioBuffer<float> makeFrame(int oscNum, int frame, int numFrames)
+    {
+        const int tableSize = 2048;
+        auto morph = numFrames > 1 ? (float)frame / (float)(numFrames - 1) : 0.f;
+
+        // one wrap sample on the end so the table's resampler never reads past the data
+        AudioBuffer<float> buffer(1, tableSize + 1);
+        auto* data = buffer.getWritePointer(0);
+
+        for (int i = 0; i <= tableSize; ++i)
+        {
+            auto phase = (float)(i % tableSize) / (float)tableSize;
+
+            if (oscNum == 1)
+            {
+                auto saw = 2.f * phase - 1.f;
+                auto square = phase < 0.5f ? 1.f : -1.f;
+                data[i] = saw + morph * (square - saw);
+            }
+            else
+            {
+                auto sine = std::sin(MathConstants<float>::twoPi * phase);
+                auto triangle = 1.f - 4.f * std::abs(phase - 0.5f);
+                data[i] = sine + morph * (triangle - sine);
+            }
+        }
+
+        return buffer;
+    }
+
+    inline void loadTables(GayPolyCommunistAudioProcessor& processor)
+    {
+        const int numFrames = 8;
+
+        for (int osc = 1; osc <= 2; ++osc)
+        {
+            processor.clearWaveTables(osc);
+
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                auto buffer = makeFrame(osc, frame, numFrames);
+                processor.loadTableFromBuffer(buffer, osc);
+            }
+        }
+
+        processor.waitForWaveTables();
+    }
+
+    inline void applyPatch(GayPolyCommunistAudioProcessor& processor, const Patch& patch)
+    {
+        auto& tree = processor.getValueTree();
+
+        for (auto& [id, value] : patch.values)
+        {
+            auto* param = tree.getParameter(id);
+            jassert(param != nullptr); // a corpus patch names a parameter that doesn't exist anymore
+
+            if (param != nullptr)
+                param->setValueNotifyingHost(param->convertTo0to1(value));
+        }
+    }
+}
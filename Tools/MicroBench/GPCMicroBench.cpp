@@ -0,0 +1,609 @@
+/*
+  ==============================================================================
+
+    GPCMicroBench.cpp
+    Created: 17 Oct 2026 2:05:31pm
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <map>
+#include "Synth/GayOscillator.h"
+#include "Synth/LadderLanes.h"
+#include "PerfCounters.h"
+
+/*
+    Per primitive benchmarks - every per sample building block of a voice, timed on its own.
+
+    gpc_microbench [--filter=name] [--sample-rate=48000] [--block-size=512] [--blocks=2000] [--frames=64]
+                   [--csv=results.csv] [--baseline=previous.csv] [--max-regression=10]
+    gpc_microbench --thd [--sample-rate=48000] [--block-size=512] [--blocks=2000]
+
+    With --baseline the run fails (exit code 1) if any kernel's ns/sample got worse than the baseline by more
+    than --max-regression percent
+
+    --thd prints the interpolation table instead: for every TableInterpolation kernel what a block of one oscillator
+    costs, and the THD+N of a clean sine read through it at a low, middle and high pitch
+*/
+
+namespace
+{
+    volatile float sink = 0.f; // keeps the optimiser from throwing the kernels away
+
+    struct Kernel
+    {
+        String name;
+        std::function<float(int numSamples)> process;
+    };
+
+    struct KernelResult
+    {
+        String name;
+        double nsPerSample = 0.0;
+        double cyclesPerSample = -1.0;
+        double cacheMissesPer1k = -1.0;
+        double branchMissesPer1k = -1.0;
+    };
+
+    //==============================================================================
+    struct BenchSettings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int numFrames = 64;
+    };
+
+    Kernel makeWaveTableKernel(const BenchSettings& s)
+    {
+        auto table = std::make_shared<WaveTable>(2048);
+        table->createSineTable();
+        table->prepare(s.sampleRate);
+        table->setFrequency(440.f);
+
+        return { "WaveTable::getNextSample", [table](int n)
+        {
+            float sum = 0.f;
+            for (int i = 0; i < n; ++i)
+                sum += table->getNextSample();
+            return sum;
+        } };
+    }
+
+    std::shared_ptr<WaveTableVector> makeWaveVector(const BenchSettings& s)
+    {
+        auto vector = std::make_shared<WaveTableVector>();
+
+        // fill with saw-ish frames of rising brightness so every frame is different data
+        AudioBuffer<float> frame(1, 2048);
+        while (vector->getBank()->getNumTables() < jmin(s.numFrames, vector->vectorSize()))
+        {
+            auto harmonics = 1 + vector->getBank()->getNumTables();
+            for (int i = 0; i < frame.getNumSamples(); ++i)
+            {
+                float v = 0.f;
+                for (int h = 1; h <= harmonics; ++h)
+                    v += std::sin(MathConstants<float>::twoPi * (float)(h * i) / 2048.f) / (float)h;
+                frame.setSample(0, i, v * 0.5f);
+            }
+            vector->loadTableFromBuffer(frame);
+        }
+
+        vector->prepare(s.sampleRate);
+        vector->setWave(0.5f);
+        vector->setFrequency(220.f);
+        return vector;
+    }
+
+    Kernel makeWaveVectorKernel(const BenchSettings& s)
+    {
+        auto vector = makeWaveVector(s);
+
+        return { "WaveTableVector::getNextSample", [vector](int n)
+        {
+            float sum = 0.f;
+            for (int i = 0; i < n; ++i)
+                sum += vector->getNextSample();
+            return sum;
+        } };
+    }
+
+    // one oscillator a block at a time, every table read through kernel
+    Kernel makeInterpolationKernel(const BenchSettings& s, TableInterpolation::Kernel kernel)
+    {
+        struct State
+        {
+            std::shared_ptr<WaveTableVector> vector;
+            std::vector<float> wave, pitch, output;
+        };
+
+        auto state = std::make_shared<State>();
+        state->vector = makeWaveVector(s);
+        state->vector->setInterpolation(kernel);
+
+        state->wave.assign((size_t)s.blockSize, 0.5f);
+        state->pitch.assign((size_t)s.blockSize, 220.f);
+        state->output.resize((size_t)s.blockSize);
+
+        return { "WaveTableVector::renderNextBlock (" + String(TableInterpolation::getName(kernel)) + ")", [state](int n)
+        {
+            state->vector->renderNextBlock(state->output.data(), state->wave.data(), state->pitch.data(), n);
+            return state->output[(size_t)n - 1];
+        } };
+    }
+
+    // a whole stereo stack per sample, compare against numVoices x WaveTableVector::getNextSample
+    Kernel makeUnisonKernel(const BenchSettings& s, int numVoices)
+    {
+        struct State
+        {
+            std::shared_ptr<WaveTableVector> vector;
+            UnisonStack unison;
+            UnisonStack::Scratch scratch;
+            std::vector<float> wave, pitch, left, right;
+        };
+
+        auto state = std::make_shared<State>();
+        state->vector = makeWaveVector(s);
+        state->unison.prepare(s.sampleRate);
+        state->unison.setParameters(numVoices, 25.f, 1.f, 0.8f, 1.f);
+        state->unison.noteOn();
+
+        state->wave.assign((size_t)s.blockSize, 0.5f);
+        state->pitch.assign((size_t)s.blockSize, 220.f);
+        state->left.resize((size_t)s.blockSize);
+        state->right.resize((size_t)s.blockSize);
+
+        return { "UnisonStack::render (" + String(numVoices) + " voices)", [state](int n)
+        {
+            state->unison.render(*state->vector, state->wave.data(), state->pitch.data(),
+                                 state->left.data(), state->right.data(), n, state->scratch);
+            return state->left[(size_t)n - 1] + state->right[(size_t)n - 1];
+        } };
+    }
+
+    Kernel makeSetFrequencyKernel(const BenchSettings& s)
+    {
+        auto vector = makeWaveVector(s);
+
+        return { "WaveTableVector::setFrequency", [vector](int n)
+        {
+            // a slowly gliding pitch, like a pitch lfo would produce
+            for (int i = 0; i < n; ++i)
+                vector->setFrequency(220.f + (float)(i & 63));
+            return vector->getWaveVal();
+        } };
+    }
+
+    // every mod assigned, and the target moving, so this is the most expensive path through each type
+    Kernel makeParamKernel(const BenchSettings& s, GayParam::ParamType type, const String& typeName)
+    {
+        struct State
+        {
+            WaveTable lfo { 2048 };
+            GayADSR env;
+            std::unique_ptr<GayParam> param;
+            bool flip = false;
+        };
+
+        auto state = std::make_shared<State>();
+        state->lfo.createSineTable();
+        state->lfo.prepare(s.sampleRate);
+        state->lfo.setFrequency(3.f);
+        state->lfo.getNextSample();
+        state->env.setSampleRate(s.sampleRate);
+        state->env.setParameters({ 0.1f, 0.1f, 0.8f, 0.2f });
+        state->env.noteOn();
+        state->env.getNextSample();
+
+        state->param = std::make_unique<GayParam>(type);
+        state->param->prepare(s.sampleRate);
+        state->param->assignLFO(&state->lfo);
+        state->param->assignEnvelope(&state->env);
+        state->param->setLFOScale(0.5f);
+        state->param->setEnvScale(0.5f);
+        state->param->setOffset(0.1f);
+
+        return { "GayParam::getNextValue (" + typeName + ")", [state](int n)
+        {
+            state->flip = ! state->flip;
+            state->param->setValue(state->flip ? 0.25f : 0.75f);
+
+            float sum = 0.f;
+            for (int i = 0; i < n; ++i)
+                sum += state->param->getNextValue();
+            return sum;
+        } };
+    }
+
+    Kernel makeADSRKernel(const BenchSettings& s)
+    {
+        struct State
+        {
+            GayADSR env;
+            int calls = 0;
+        };
+
+        auto state = std::make_shared<State>();
+        state->env.setSampleRate(s.sampleRate);
+        state->env.setParameters({ 0.005f, 0.01f, 0.5f, 0.01f });
+
+        return { "GayADSR::getNextSample", [state](int n)
+        {
+            // alternate note on / off so the loop sees every stage, not just sustain
+            if ((++state->calls & 1) != 0)
+                state->env.noteOn();
+            else
+                state->env.noteOff();
+
+            float sum = 0.f;
+            for (int i = 0; i < n; ++i)
+                sum += state->env.getNextSample();
+            return sum;
+        } };
+    }
+
+    // configured the way GayVoice configures it: LPF24, stereo, parameters pushed once per block.
+    // factorLog2 > 0 wraps it in the voice's polyphase IIR oversampling
+    Kernel makeLadderKernel(const BenchSettings& s, int factorLog2 = 0)
+    {
+        struct State
+        {
+            dsp::LadderFilter<float> filter;
+            std::unique_ptr<dsp::Oversampling<float>> oversampler;
+            AudioBuffer<float> noise;
+            AudioBuffer<float> work;
+            int calls = 0;
+        };
+
+        auto state = std::make_shared<State>();
+        auto factor = (uint32)1 << (uint32)factorLog2;
+        state->filter.prepare({ s.sampleRate * factor, (uint32)s.blockSize * factor, 2 });
+
+        if (factorLog2 > 0)
+        {
+            state->oversampler = std::make_unique<dsp::Oversampling<float>>(2, (size_t)factorLog2,
+                                                                             dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, false);
+            state->oversampler->initProcessing((size_t)s.blockSize);
+        }
+
+        state->filter.setMode(dsp::LadderFilter<float>::Mode::LPF24);
+        state->noise.setSize(2, s.blockSize);
+        state->work.setSize(2, s.blockSize);
+
+        Random random(1234);
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < s.blockSize; ++i)
+                state->noise.setSample(ch, i, random.nextFloat() * 0.6f - 0.3f);
+
+        auto name = factorLog2 > 0 ? "dsp::LadderFilter (voice setup, " + String((int)factor) + "x IIR)" : String("dsp::LadderFilter (voice setup)");
+
+        return { name, [state](int n)
+        {
+            auto c = (float)(++state->calls & 15);
+            state->filter.setCutoffFrequencyHz(400.f + c * 200.f);
+            state->filter.setDrive(1.f + c * 0.25f);
+            state->filter.setResonance(jlimit(0.f, 1.f, c / 16.f));
+
+            state->work.makeCopyOf(state->noise, true);
+            auto block = dsp::AudioBlock<float>(state->work).getSubBlock(0, (size_t)n);
+
+            if (state->oversampler != nullptr)
+            {
+                auto upsampled = state->oversampler->processSamplesUp(block);
+                state->filter.process(dsp::ProcessContextReplacing<float>(upsampled));
+                state->oversampler->processSamplesDown(block);
+            }
+            else
+            {
+                state->filter.process(dsp::ProcessContextReplacing<float>(block));
+            }
+
+            return state->work.getSample(0, n - 1);
+        } };
+    }
+
+    /*
+        A full bank of mono voice filters, the way the lane engine runs them: every voice has its own audio and the
+        cutoff sweeps. JUCE's gets the cutoff once a block, LadderLanes reads it per sample.
+        ns/sample here is for all the voices together
+    */
+    Kernel makeVoiceFilterKernel(const BenchSettings& s, int numVoices, bool useLanes)
+    {
+        struct State
+        {
+            std::vector<dsp::LadderFilter<float>> filters;
+            std::vector<LadderLanes::State> ladderStates;
+            std::vector<LadderLanes::Lane> lanes;
+            LadderLanes ladder;
+            AudioBuffer<float> noise, work;
+            std::vector<float> cutoff;
+            int calls = 0;
+        };
+
+        auto state = std::make_shared<State>();
+        state->filters.resize((size_t)numVoices);
+        state->ladderStates.resize((size_t)numVoices);
+        state->lanes.resize((size_t)numVoices);
+        state->cutoff.resize((size_t)s.blockSize);
+        state->noise.setSize(numVoices, s.blockSize);
+        state->work.setSize(numVoices, s.blockSize);
+
+        for (auto& filter : state->filters)
+        {
+            filter.prepare({ s.sampleRate, (uint32)s.blockSize, 1 });
+            filter.setMode(dsp::LadderFilter<float>::Mode::LPF24);
+        }
+
+        Random random(1234);
+        for (int ch = 0; ch < numVoices; ++ch)
+            for (int i = 0; i < s.blockSize; ++i)
+                state->noise.setSample(ch, i, random.nextFloat() * 0.6f - 0.3f);
+
+        auto name = String(useLanes ? "LadderLanes" : "dsp::LadderFilter") + " (" + String(numVoices) + " voices)";
+
+        return { name, [state, numVoices, useLanes, sampleRate = (float)s.sampleRate](int n)
+        {
+            auto c = (float)(++state->calls & 15);
+            for (int i = 0; i < n; ++i)
+                state->cutoff[(size_t)i] = 400.f + (c + (float)i / (float)n) * 200.f;
+
+            state->work.makeCopyOf(state->noise, true);
+
+            if (useLanes)
+            {
+                for (int v = 0; v < numVoices; ++v)
+                {
+                    auto& lane = state->lanes[(size_t)v];
+                    lane.state = &state->ladderStates[(size_t)v];
+                    lane.audio = state->work.getWritePointer(v);
+                    lane.cutoff = state->cutoff.data();
+                    lane.numSamples = n;
+                    lane.resonance = jlimit(0.f, 1.f, c / 16.f);
+                    lane.drive = 1.f + c * 0.25f;
+                    lane.sampleRate = sampleRate;
+                }
+
+                state->ladder.process(state->lanes.data(), numVoices);
+            }
+            else
+            {
+                for (int v = 0; v < numVoices; ++v)
+                {
+                    auto& filter = state->filters[(size_t)v];
+                    filter.setCutoffFrequencyHz(state->cutoff[(size_t)n - 1]);
+                    filter.setDrive(1.f + c * 0.25f);
+                    filter.setResonance(jlimit(0.f, 1.f, c / 16.f));
+
+                    auto block = dsp::AudioBlock<float>(state->work).getSingleChannelBlock((size_t)v).getSubBlock(0, (size_t)n);
+                    filter.process(dsp::ProcessContextReplacing<float>(block));
+                }
+            }
+
+            return state->work.getSample(0, n - 1);
+        } };
+    }
+
+    /*
+        THD+N of a sine read through kernel at freq, in dB under the fundamental. freq gets moved onto the nearest
+        fft bin so the window is the only leakage, everything more than 6 bins from the fundamental (and dc) is
+        distortion or noise
+    */
+    double measureTHDN(TableInterpolation::Kernel kernel, double sampleRate, double freq)
+    {
+        constexpr int fftOrder = 16, fftSize = 1 << fftOrder, fundamentalWidth = 6;
+
+        auto fundamentalBin = roundToInt(freq * fftSize / sampleRate);
+        freq = fundamentalBin * sampleRate / fftSize;
+
+        WaveTableVector vector; // nothing loaded is a band limited sine
+        vector.prepare(sampleRate);
+        vector.setInterpolation(kernel);
+
+        std::vector<float> wave((size_t)fftSize, 0.f), pitch((size_t)fftSize, (float)freq), window((size_t)fftSize);
+        std::vector<float> spectrum((size_t)fftSize * 2, 0.f);
+        vector.renderNextBlock(spectrum.data(), wave.data(), pitch.data(), fftSize);
+
+        dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t)fftSize, dsp::WindowingFunction<float>::blackmanHarris, false);
+        FloatVectorOperations::multiply(spectrum.data(), window.data(), fftSize);
+
+        dsp::FFT fft(fftOrder);
+        fft.performFrequencyOnlyForwardTransform(spectrum.data());
+
+        double fundamental = 0.0, rest = 0.0;
+        for (int bin = fundamentalWidth; bin <= fftSize / 2; ++bin)
+        {
+            auto power = (double)spectrum[(size_t)bin] * (double)spectrum[(size_t)bin];
+            (std::abs(bin - fundamentalBin) <= fundamentalWidth ? fundamental : rest) += power;
+        }
+
+        return 10.0 * std::log10(jmax(rest, 1.0e-30) / jmax(fundamental, 1.0e-30));
+    }
+
+    //==============================================================================
+    KernelResult runKernel(Kernel& kernel, PerfCounters& counters, int blockSize, int numBlocks)
+    {
+        for (int i = 0; i < jmax(10, numBlocks / 10); ++i) // warm caches and branch predictors
+            sink = sink + kernel.process(blockSize);
+
+        Array<double> blockNs;
+        uint64 totals[PerfCounters::numCounters] = {};
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            counters.start();
+            auto start = Time::getHighResolutionTicks();
+            sink = sink + kernel.process(blockSize);
+            auto ticks = Time::getHighResolutionTicks() - start;
+            counters.stop();
+
+            blockNs.add(Time::highResolutionTicksToSeconds(ticks) * 1.0e9);
+            for (int c = 0; c < PerfCounters::numCounters; ++c)
+                totals[c] += counters.get((PerfCounters::Counter)c);
+        }
+
+        // median block, it's far less noisy than the mean on a shared box
+        std::sort(blockNs.begin(), blockNs.end());
+
+        KernelResult r;
+        r.name = kernel.name;
+        r.nsPerSample = blockNs[blockNs.size() / 2] / (double)blockSize;
+
+        auto totalSamples = (double)blockSize * (double)numBlocks;
+        if (counters.isAvailable(PerfCounters::cycles))
+            r.cyclesPerSample = (double)totals[PerfCounters::cycles] / totalSamples;
+        if (counters.isAvailable(PerfCounters::cacheMisses))
+            r.cacheMissesPer1k = (double)totals[PerfCounters::cacheMisses] * 1000.0 / totalSamples;
+        if (counters.isAvailable(PerfCounters::branchMisses))
+            r.branchMissesPer1k = (double)totals[PerfCounters::branchMisses] * 1000.0 / totalSamples;
+
+        return r;
+    }
+
+    String formatCounter(double v)
+    {
+        return v < 0.0 ? String("n/a") : String(v, 2);
+    }
+
+    // name -> ns/sample from a previous --csv run
+    std::map<String, double> readBaseline(const File& file)
+    {
+        std::map<String, double> baseline;
+        StringArray lines;
+        file.readLines(lines);
+
+        for (int i = 1; i < lines.size(); ++i)
+        {
+            auto cols = StringArray::fromTokens(lines[i], ",", "\"");
+            if (cols.size() >= 2)
+                baseline[cols[0].unquoted()] = cols[1].getDoubleValue();
+        }
+
+        return baseline;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+    ScopedJuceInitialiser_GUI juceInit;
+
+    BenchSettings settings;
+    if (args.containsOption("--sample-rate"))
+        settings.sampleRate = args.getValueForOption("--sample-rate").getDoubleValue();
+    if (args.containsOption("--block-size"))
+        settings.blockSize = jmax(16, args.getValueForOption("--block-size").getIntValue());
+    if (args.containsOption("--frames"))
+        settings.numFrames = jlimit(1, WavetableBank::maxTables, args.getValueForOption("--frames").getIntValue());
+
+    auto numBlocks = args.containsOption("--blocks") ? jmax(10, args.getValueForOption("--blocks").getIntValue()) : 2000;
+    auto filter = args.getValueForOption("--filter");
+    auto maxRegression = args.containsOption("--max-regression") ? args.getValueForOption("--max-regression").getDoubleValue() : 10.0;
+
+    PerfCounters counters;
+
+    if (args.containsOption("--thd"))
+    {
+        const double pitches[] = { 1000.0, 5000.0, 12000.0 };
+
+        std::cout << String::formatted("%-12s %10s", "kernel", "ns/smp");
+        for (auto freq : pitches)
+            std::cout << String::formatted(" %14s", ("THD+N " + String(roundToInt(freq / 1000.0)) + "k").toRawUTF8());
+        std::cout << std::endl;
+
+        for (int k = 0; k < (int)TableInterpolation::Kernel::numKernels; ++k)
+        {
+            auto kernel = (TableInterpolation::Kernel)k;
+            auto bench = makeInterpolationKernel(settings, kernel);
+            auto r = runKernel(bench, counters, settings.blockSize, numBlocks);
+
+            std::cout << String(TableInterpolation::getName(kernel)).paddedRight(' ', 12) << " "
+                      << String(r.nsPerSample, 3).paddedLeft(' ', 10);
+
+            for (auto freq : pitches)
+                std::cout << " " << (String(measureTHDN(kernel, settings.sampleRate, freq), 1) + " dB").paddedLeft(' ', 14);
+
+            std::cout << std::endl;
+        }
+
+        return 0;
+    }
+
+    std::vector<Kernel> kernels;
+    kernels.push_back(makeWaveTableKernel(settings));
+    kernels.push_back(makeWaveVectorKernel(settings));
+    kernels.push_back(makeSetFrequencyKernel(settings));
+
+    for (int k = 0; k < (int)TableInterpolation::Kernel::numKernels; ++k)
+        kernels.push_back(makeInterpolationKernel(settings, (TableInterpolation::Kernel)k));
+
+    kernels.push_back(makeUnisonKernel(settings, 8));
+    kernels.push_back(makeUnisonKernel(settings, 16));
+    kernels.push_back(makeParamKernel(settings, GayParam::ParamType::gain, "gain"));
+    kernels.push_back(makeParamKernel(settings, GayParam::ParamType::pitch, "pitch"));
+    kernels.push_back(makeParamKernel(settings, GayParam::ParamType::wave, "wave"));
+    kernels.push_back(makeADSRKernel(settings));
+    kernels.push_back(makeLadderKernel(settings));
+    kernels.push_back(makeLadderKernel(settings, 1));
+    kernels.push_back(makeLadderKernel(settings, 2));
+    kernels.push_back(makeLadderKernel(settings, 3));
+    kernels.push_back(makeVoiceFilterKernel(settings, 32, false));
+    kernels.push_back(makeVoiceFilterKernel(settings, 32, true));
+
+    if (! counters.isAvailable(PerfCounters::cycles))
+        std::cout << "(hardware counters unavailable, wall time only)" << std::endl;
+
+    std::cout << String::formatted("%-44s %10s %10s %12s %12s", "kernel", "ns/smp", "cyc/smp", "llc-miss/1k", "br-miss/1k") << std::endl;
+
+    std::vector<KernelResult> results;
+    for (auto& k : kernels)
+    {
+        if (filter.isNotEmpty() && ! k.name.containsIgnoreCase(filter))
+            continue;
+
+        auto r = runKernel(k, counters, settings.blockSize, numBlocks);
+        results.push_back(r);
+
+        std::cout << r.name.paddedRight(' ', 44) << " "
+                  << String(r.nsPerSample, 3).paddedLeft(' ', 10) << " "
+                  << formatCounter(r.cyclesPerSample).paddedLeft(' ', 10) << " "
+                  << formatCounter(r.cacheMissesPer1k).paddedLeft(' ', 12) << " "
+                  << formatCounter(r.branchMissesPer1k).paddedLeft(' ', 12) << std::endl;
+    }
+
+    if (args.containsOption("--csv"))
+    {
+        String csv = "kernel,ns_per_sample,cycles_per_sample,cache_misses_per_1k,branch_misses_per_1k\n";
+        for (auto& r : results)
+            csv << r.name.quoted() << "," << r.nsPerSample << "," << r.cyclesPerSample << ","
+                << r.cacheMissesPer1k << "," << r.branchMissesPer1k << "\n";
+
+        args.getFileForOption("--csv").replaceWithText(csv);
+    }
+
+    int exitCode = 0;
+    if (args.containsOption("--baseline"))
+    {
+        auto baseline = readBaseline(args.getFileForOption("--baseline"));
+
+        for (auto& r : results)
+        {
+            auto it = baseline.find(r.name);
+            if (it == baseline.end() || it->second <= 0.0)
+                continue;
+
+            auto change = (r.nsPerSample / it->second - 1.0) * 100.0;
+            if (change > maxRegression)
+            {
+                std::cout << "REGRESSION " << r.name << ": " << String(it->second, 3) << " -> "
+                          << String(r.nsPerSample, 3) << " ns/smp (+" << String(change, 1) << "%)" << std::endl;
+                exitCode = 1;
+            }
+        }
+    }
+
+    return exitCode;
+}
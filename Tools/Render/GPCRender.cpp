@@ -0,0 +1,251 @@
+/*
+  ==============================================================================
+
+    GPCRender.cpp
+    Created: 17 Oct 2026 11:52:19am
+    Author:  ryand
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "OfflineRenderer.h"
+
+/*
+    MIDI file -> WAV bouncer.
+
+    gpc_render --midi=song.mid --out=song.wav [--preset=state.bin] [--sample-rate=48000] [--block-size=512]
+               [--bits=24] [--no-voice-check] [--shards=1|N|auto] [--tail=seconds]
+
+    --preset takes a blob written by getStateInformation.
+    --shards splits the file at points where nothing is sounding (no held notes, no sustain pedal, and at least
+    a release plus the filter's longest ring out of silence before the next note) and renders the pieces on
+    separate cores, each with its own processor. Oscillator and LFO phases restart at each split, so sharded renders
+    aren't sample identical to a single pass - use --shards=1 for anything that gets null tested.
+    --tail overrides that gap, which is also how long the file runs on past the last event.
+*/
+
+namespace
+{
+    struct Region
+    {
+        int64 start = 0, end = 0;
+    };
+
+    // contiguous regions covering the whole sequence, split where nothing can still be sounding
+    std::vector<Region> findIndependentRegions(const MidiMessageSequence& sequence, int64 tailSamples)
+    {
+        std::vector<Region> regions;
+        int held[16][128] = {};
+        bool sustained[16] = {};
+        int numHeld = 0;
+        int64 regionStart = 0, quietSince = -1, lastEvent = 0;
+
+        for (int i = 0; i < sequence.getNumEvents(); ++i)
+        {
+            auto& m = sequence.getEventPointer(i)->message;
+            auto t = (int64)m.getTimeStamp();
+            auto ch = jlimit(0, 15, m.getChannel() - 1);
+            lastEvent = jmax(lastEvent, t);
+
+            if (m.isNoteOn())
+            {
+                if (numHeld == 0 && quietSince >= 0 && t - quietSince >= tailSamples)
+                {
+                    regions.push_back({ regionStart, quietSince + tailSamples });
+                    regionStart = quietSince + tailSamples;
+                }
+
+                ++held[ch][m.getNoteNumber()];
+                ++numHeld;
+                quietSince = -1;
+            }
+            else if (m.isNoteOff() && held[ch][m.getNoteNumber()] > 0)
+            {
+                --held[ch][m.getNoteNumber()];
+                --numHeld;
+            }
+            else if (m.isSustainPedalOn())
+            {
+                sustained[ch] = true;
+            }
+            else if (m.isSustainPedalOff())
+            {
+                sustained[ch] = false;
+            }
+
+            auto pedalDown = std::any_of(std::begin(sustained), std::end(sustained), [](bool b) { return b; });
+            if (numHeld == 0 && ! pedalDown && quietSince < 0)
+                quietSince = t;
+        }
+
+        regions.push_back({ regionStart, jmax(regionStart, lastEvent) + tailSamples });
+        return regions;
+    }
+
+    // groups neighbouring regions into roughly equal length shards
+    std::vector<Region> planShards(const std::vector<Region>& regions, int numShards)
+    {
+        std::vector<Region> shards;
+        auto total = regions.back().end - regions.front().start;
+        auto target = total / jmax(1, numShards);
+
+        Region current = regions.front();
+        for (size_t i = 1; i < regions.size(); ++i)
+        {
+            if (current.end - current.start >= target)
+            {
+                shards.push_back(current);
+                current = regions[i];
+            }
+            else
+            {
+                current.end = regions[i].end;
+            }
+        }
+
+        shards.push_back(current);
+        return shards;
+    }
+
+    struct ShardResult
+    {
+        Region region;
+        OfflineRenderer::Stats stats;
+        AudioBuffer<float> audio; // the shard on its own, copied into the output once every shard is done
+    };
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+    ScopedJuceInitialiser_GUI juceInit;
+
+    auto midiFile = args.containsOption("--midi") ? args.getFileForOption("--midi") : File();
+    auto outFile = args.containsOption("--out") ? args.getFileForOption("--out") : File();
+
+    if (! midiFile.existsAsFile() || outFile == File())
+    {
+        std::cerr << "usage: gpc_render --midi=song.mid --out=song.wav [--preset=state.bin] [--sample-rate=48000]"
+                     " [--block-size=512] [--bits=24] [--no-voice-check] [--shards=1|N|auto] [--tail=seconds]" << std::endl;
+        return 1;
+    }
+
+    auto sampleRate = args.containsOption("--sample-rate") ? args.getValueForOption("--sample-rate").getDoubleValue() : 48000.0;
+    auto blockSize = args.containsOption("--block-size") ? args.getValueForOption("--block-size").getIntValue() : 512;
+    auto bits = args.containsOption("--bits") ? args.getValueForOption("--bits").getIntValue() : 24;
+    auto checkVoices = ! args.containsOption("--no-voice-check");
+    auto presetFile = args.containsOption("--preset") ? args.getFileForOption("--preset") : File();
+
+    auto shardOption = args.getValueForOption("--shards");
+    auto numShards = shardOption == "auto" ? SystemStats::getNumCpus() : jmax(1, shardOption.getIntValue());
+
+    auto sequence = OfflineRenderer::loadMidiFile(midiFile, sampleRate);
+    if (sequence.getNumEvents() == 0)
+    {
+        std::cerr << "couldn't read any midi events from " << midiFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // one processor per shard, all built and loaded here on the message thread
+    OwnedArray<GayPolyCommunistAudioProcessor> processors;
+    auto makeProcessor = [&]
+    {
+        auto* p = processors.add(new GayPolyCommunistAudioProcessor());
+        if (presetFile != File() && ! OfflineRenderer::loadPreset(*p, presetFile))
+            std::cerr << "couldn't load preset " << presetFile.getFullPathName() << std::endl;
+
+        p->setVoiceCheckEnabled(checkVoices);
+        return p;
+    };
+    makeProcessor();
+
+    // a voice sounds for the amp envelope's release after its note off, then the filter can ring for up to maxTailSeconds
+    auto release = processors[0]->getValueTree().getRawParameterValue("RELEASE 1")->load();
+    auto tailSeconds = args.containsOption("--tail") ? args.getValueForOption("--tail").getDoubleValue()
+                                                     : release + GayVoice::maxTailSeconds;
+    auto tailSamples = (int64)(tailSeconds * sampleRate);
+
+    auto regions = findIndependentRegions(sequence, tailSamples);
+    auto shards = numShards > 1 ? planShards(regions, numShards) : std::vector<Region>{ { regions.front().start, regions.back().end } };
+
+    while (processors.size() < (int)shards.size())
+        makeProcessor();
+
+    auto totalSamples = shards.back().end;
+    std::vector<ShardResult> results(shards.size());
+    auto wallStart = Time::getHighResolutionTicks();
+
+    {
+        ThreadPool pool(jmin(numShards, (int)shards.size()));
+
+        for (size_t i = 0; i < shards.size(); ++i)
+        {
+            pool.addJob([&, i]
+            {
+                // each shard into a buffer of its own, AudioBuffer's clear flag isn't safe to share between threads
+                auto& result = results[i];
+                auto length = shards[i].end - shards[i].start;
+                result.region = shards[i];
+                result.audio.setSize(2, (int)length);
+                result.audio.clear();
+
+                OfflineRenderer renderer(*processors[(int)i], sampleRate, blockSize);
+                result.stats = renderer.render(sequence, shards[i].start, length, result.audio, 0);
+            });
+        }
+
+        while (pool.getNumJobs() > 0)
+            Thread::sleep(1);
+    }
+
+    AudioBuffer<float> output(2, (int)totalSamples);
+    output.clear();
+
+    for (auto& r : results)
+    {
+        for (int ch = 0; ch < output.getNumChannels(); ++ch)
+            output.addFrom(ch, (int)r.region.start, r.audio, ch, 0, r.audio.getNumSamples());
+
+        r.audio.setSize(0, 0);
+    }
+
+    auto wallSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - wallStart);
+
+    if (! OfflineRenderer::writeWav(outFile, output, sampleRate, bits))
+    {
+        std::cerr << "couldn't write " << outFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    //==============================================================================
+    auto audioSeconds = (double)totalSamples / sampleRate;
+    double cpuSeconds = 0.0, worstBlock = 0.0;
+    int totalBlocks = 0;
+
+    for (auto& r : results)
+    {
+        cpuSeconds += r.stats.seconds;
+        worstBlock = jmax(worstBlock, r.stats.worstBlockSeconds);
+        totalBlocks += r.stats.blocks;
+
+        if (results.size() > 1)
+            std::cout << String::formatted("  shard %8.2fs - %8.2fs  %7.2fx realtime",
+                                           (double)r.region.start / sampleRate, (double)r.region.end / sampleRate,
+                                           r.stats.seconds > 0.0 ? (double)r.stats.samples / sampleRate / r.stats.seconds : 0.0)
+                      << std::endl;
+    }
+
+    std::cout << outFile.getFileName() << ": " << String(audioSeconds, 2) << "s of audio, "
+              << (int)regions.size() << " independent regions, " << (int)shards.size() << " shards" << std::endl;
+    std::cout << String::formatted("wall %.3fs (%.1fx realtime), cpu in processBlock %.3fs (%.1fx realtime per core)",
+                                   wallSeconds, audioSeconds / jmax(1.0e-9, wallSeconds),
+                                   cpuSeconds, audioSeconds / jmax(1.0e-9, cpuSeconds)) << std::endl;
+    std::cout << String::formatted("%.2f Msamples/s, %d blocks, worst block %.1fus (%.1f%% of its duration)",
+                                   (double)totalSamples / jmax(1.0e-9, wallSeconds) * 1.0e-6, totalBlocks,
+                                   worstBlock * 1.0e6, worstBlock / ((double)blockSize / sampleRate) * 100.0) << std::endl;
+
+    return 0;
+}